@@ -8,6 +8,7 @@
 #include "Systems/ResolveSystem.h"
 #include "Systems/ComputeSystem.h"
 #include "Systems/ProcrastinatedRenderSystem.h"
+#include "Systems/DepthPyramidSystem.h"
 
 #include "Constants/AreaTex.h"
 #include "Constants/SearchTex.h"
@@ -21,6 +22,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <filesystem>
 
 #include <banan_logger.h>
 
@@ -29,30 +31,34 @@ namespace Banan{
     BananEngineTest::BananEngineTest() {
 
         loadGameObjects();
+        gameObjects.setGpuTransforms(true);
+
+        mipFeedback = std::make_unique<BananMipFeedback>(bananDevice, gameObjects.getTextureSlotCapacity());
 
         globalPool = BananDescriptorPool::Builder(bananDevice)
                 .setMaxSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, BananSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BananSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BananSwapChain::MAX_FRAMES_IN_FLIGHT * 8)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .build();
 
         texturePool = BananDescriptorPool::Builder(bananDevice)
                 .setMaxSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT * gameObjects.size())
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT * gameObjects.getTextureSlotCapacity())
                 .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .build();
 
         normalPool = BananDescriptorPool::Builder(bananDevice)
                 .setMaxSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT * gameObjects.size())
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT * gameObjects.getTextureSlotCapacity())
                 .build();
 
         heightPool = BananDescriptorPool::Builder(bananDevice)
                 .setMaxSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT * gameObjects.size())
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT * gameObjects.getTextureSlotCapacity())
                 .build();
 
         procrastinatedPool = BananDescriptorPool::Builder(bananDevice)
@@ -74,6 +80,13 @@ namespace Banan{
                 .setMaxSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT * 2)
                 .build();
+
+        depthPyramidPool = BananDescriptorPool::Builder(bananDevice)
+                .setMaxSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BananSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, BananSwapChain::MAX_FRAMES_IN_FLIGHT * BananDepthPyramid::MAX_LEVELS)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, BananSwapChain::MAX_FRAMES_IN_FLIGHT)
+                .build();
     }
 
     BananEngineTest::~BananEngineTest() = default;
@@ -86,22 +99,24 @@ namespace Banan{
             uboBuffer->map();
         }
 
-        std::vector<std::unique_ptr<BananBuffer>> storageBuffers(BananSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (auto & storageBuffer : storageBuffers) {
-            storageBuffer = std::make_unique<BananBuffer>(bananDevice, sizeof(GameObjectData), gameObjects.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0);
-            storageBuffer->map();
-        }
-
         auto globalSetLayout = BananDescriptorSetLayout::Builder(bananDevice)
                 .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT, 1)
                 .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
+                .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .addBinding(7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .addBinding(8, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .addBinding(9, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 1)
                 .build();
 
         auto textureSetLayout = BananDescriptorSetLayout::Builder(bananDevice)
                 .addFlag(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT)
                 .addFlag(VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT)
                 .addFlag(VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT)
-                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, gameObjects.size())
+                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, gameObjects.getTextureSlotCapacity())
                 //.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
                 .build();
 
@@ -109,14 +124,14 @@ namespace Banan{
                 .addFlag(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT)
                 .addFlag(VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT)
                 .addFlag(VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT)
-                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, gameObjects.size())
+                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, gameObjects.getTextureSlotCapacity())
                 .build();
 
         auto heightMapSetLayout = BananDescriptorSetLayout::Builder(bananDevice)
                 .addFlag(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT)
                 .addFlag(VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT)
                 .addFlag(VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT)
-                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, gameObjects.size())
+                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, gameObjects.getTextureSlotCapacity())
                 .build();
 
         auto procrastinatedSetLayout = BananDescriptorSetLayout::Builder(bananDevice)
@@ -140,10 +155,17 @@ namespace Banan{
                 .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS, 1)
                 .build();
 
+        auto depthPyramidSetLayout = BananDescriptorSetLayout::Builder(bananDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, BananDepthPyramid::MAX_LEVELS)
+                .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+                .build();
+
         ComputeSystem computeSystem{bananDevice, {globalSetLayout->getDescriptorSetLayout()}};
+        DepthPyramidSystem depthPyramidSystem{bananDevice, {depthPyramidSetLayout->getDescriptorSetLayout()}};
 
-        PointLightSystem pointLightSystem{bananDevice, bananRenderer.getGeometryRenderPass(), {globalSetLayout->getDescriptorSetLayout()}};
-        ProcrastinatedRenderSystem procrastinatedRenderSystem{bananDevice, bananRenderer.getGeometryRenderPass(), {globalSetLayout->getDescriptorSetLayout(), textureSetLayout->getDescriptorSetLayout(), normalSetLayout->getDescriptorSetLayout(), heightMapSetLayout->getDescriptorSetLayout()}, {globalSetLayout->getDescriptorSetLayout(), procrastinatedSetLayout->getDescriptorSetLayout()}};
+        PointLightSystem pointLightSystem{bananDevice, bananRenderer.getGeometryRenderPass(), {globalSetLayout->getDescriptorSetLayout()}, MAX_GAME_OBJECTS};
+        ProcrastinatedRenderSystem procrastinatedRenderSystem{bananDevice, bananRenderer, jobSystem, bananRenderer.getGeometryRenderPass(), {globalSetLayout->getDescriptorSetLayout(), textureSetLayout->getDescriptorSetLayout(), normalSetLayout->getDescriptorSetLayout(), heightMapSetLayout->getDescriptorSetLayout()}, {globalSetLayout->getDescriptorSetLayout(), procrastinatedSetLayout->getDescriptorSetLayout()}, MAX_GAME_OBJECTS};
         ResolveSystem resolveSystem{bananDevice, bananRenderer.getEdgeDetectionRenderPass(), bananRenderer.getBlendWeightRenderPass(), bananRenderer.getResolveRenderPass(), {globalSetLayout->getDescriptorSetLayout(), edgeDetectionSetLayout->getDescriptorSetLayout()}, {globalSetLayout->getDescriptorSetLayout(), blendWeightSetLayout->getDescriptorSetLayout()}, {globalSetLayout->getDescriptorSetLayout(), resolveLayout->getDescriptorSetLayout()}};
 
         BananCamera camera{};
@@ -156,6 +178,7 @@ namespace Banan{
         std::vector<VkDescriptorSet> edgeDetectionDescriptorSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT);
         std::vector<VkDescriptorSet> blendWeightDescriptorSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT);
         std::vector<VkDescriptorSet> resolveDescriptorSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT);
+        std::vector<VkDescriptorSet> depthPyramidDescriptorSets(BananSwapChain::MAX_FRAMES_IN_FLIGHT);
 
         for (int i = 0; i < BananSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
 
@@ -163,25 +186,44 @@ namespace Banan{
             auto bufferInfo = uboBuffers[i]->descriptorInfo();
             writer.writeBuffer(0, &bufferInfo);
 
-            auto storageInfo = storageBuffers[i]->descriptorInfo();
+            auto storageInfo = gameObjects.getBufferInfo(i);
             writer.writeBuffer(1, &storageInfo);
 
+            auto feedbackInfo = mipFeedback->descriptorInfo(i);
+            writer.writeBuffer(2, &feedbackInfo);
+
+            auto instanceInfo = procrastinatedRenderSystem.getInstanceBufferInfo(i);
+            writer.writeBuffer(3, &instanceInfo);
+
+            auto objectModelInfo = procrastinatedRenderSystem.getObjectModelBufferInfo(i);
+            writer.writeBuffer(4, &objectModelInfo);
+
+            auto modelInfo = procrastinatedRenderSystem.getModelBufferInfo(i);
+            writer.writeBuffer(5, &modelInfo);
+
+            auto drawInfo = procrastinatedRenderSystem.getDrawBufferInfo(i);
+            writer.writeBuffer(6, &drawInfo);
+
+            auto visibilityInfo = procrastinatedRenderSystem.getVisibilityBufferInfo();
+            writer.writeBuffer(7, &visibilityInfo);
+
+            auto pyramidInfo = bananRenderer.getDepthPyramid().descriptorInfo();
+            writer.writeImage(8, &pyramidInfo);
+
+            auto lightInfo = pointLightSystem.getLightBufferInfo(i);
+            writer.writeBuffer(9, &lightInfo);
+
             writer.build(globalDescriptorSets[i], std::vector<uint32_t> {});
 
+            // the bindless arrays are filled in by the game object manager as textures get slots
             BananDescriptorWriter textureWriter = BananDescriptorWriter(*textureSetLayout, *texturePool);
-            textureWriter.writeImages(0, gameObjectsTextureInfo);
-
-            textureWriter.build(textureDescriptorSets[i], std::vector<uint32_t> {static_cast<uint32_t>(gameObjectsTextureInfo.size())});
+            textureWriter.build(textureDescriptorSets[i], std::vector<uint32_t> {gameObjects.getTextureSlotCapacity()});
 
             BananDescriptorWriter normalWriter = BananDescriptorWriter(*normalSetLayout, *normalPool);
-            normalWriter.writeImages(0, gameObjectsNormalInfo);
-
-            normalWriter.build(normalDescriptorSets[i], std::vector<uint32_t> {static_cast<uint32_t>(gameObjectsNormalInfo.size())});
+            normalWriter.build(normalDescriptorSets[i], std::vector<uint32_t> {gameObjects.getTextureSlotCapacity()});
 
             BananDescriptorWriter heightWriter = BananDescriptorWriter(*heightMapSetLayout, *heightPool);
-            heightWriter.writeImages(0, gameObjectsHeightInfo);
-
-            heightWriter.build(heightDescriptorSets[i], std::vector<uint32_t> {static_cast<uint32_t>(gameObjectsHeightInfo.size())});
+            heightWriter.build(heightDescriptorSets[i], std::vector<uint32_t> {gameObjects.getTextureSlotCapacity()});
 
             BananDescriptorWriter procrastinatedWriter = BananDescriptorWriter(*procrastinatedSetLayout, *procrastinatedPool);
 
@@ -222,12 +264,29 @@ namespace Banan{
             resolveWriter.writeImage(1, &blendInfo);
 
             resolveWriter.build(resolveDescriptorSets[i], std::vector<uint32_t> {});
+
+            BananDescriptorWriter depthPyramidWriter(*depthPyramidSetLayout, *depthPyramidPool);
+
+            auto pyramidDepthInfo = bananRenderer.getGBufferDescriptorInfo()[0];
+            auto pyramidCounterInfo = bananRenderer.getDepthPyramid().counterDescriptorInfo();
+            auto pyramidLevelInfos = bananRenderer.getDepthPyramid().levelDescriptorInfos();
+            std::unordered_map<uint32_t, VkDescriptorImageInfo> pyramidLevels;
+            for (uint32_t level = 0; level < pyramidLevelInfos.size(); level++) {
+                pyramidLevels[level] = pyramidLevelInfos[level];
+            }
+
+            depthPyramidWriter.writeImage(0, &pyramidDepthInfo);
+            depthPyramidWriter.writeImages(1, pyramidLevels);
+            depthPyramidWriter.writeBuffer(2, &pyramidCounterInfo);
+
+            depthPyramidWriter.build(depthPyramidDescriptorSets[i], std::vector<uint32_t> {});
         }
 
-        auto viewerObject = BananGameObject::createGameObject();
+        TransformComponent viewerTransform{};
         KeyboardMovementController cameraController{};
 
         auto currentTime = std::chrono::high_resolution_clock::now();
+        int frameNumber = 0;
 
         while(true)
         {
@@ -279,10 +338,34 @@ namespace Banan{
                             resolveWriter.writeImage(1, &blendInfo);
 
                             resolveWriter.overwrite(resolveDescriptorSets[i]);
+
+                            // the pyramid is rebuilt at the new size along with the depth attachment it reduces
+                            BananDescriptorWriter pyramidWriter(*globalSetLayout, *globalPool);
+
+                            auto pyramidInfo = bananRenderer.getDepthPyramid().descriptorInfo();
+                            pyramidWriter.writeImage(8, &pyramidInfo);
+                            pyramidWriter.overwrite(globalDescriptorSets[i]);
+
+                            BananDescriptorWriter depthPyramidWriter(*depthPyramidSetLayout, *depthPyramidPool);
+
+                            auto pyramidDepthInfo = bananRenderer.getGBufferDescriptorInfo()[0];
+                            auto pyramidCounterInfo = bananRenderer.getDepthPyramid().counterDescriptorInfo();
+                            auto pyramidLevelInfos = bananRenderer.getDepthPyramid().levelDescriptorInfos();
+                            std::unordered_map<uint32_t, VkDescriptorImageInfo> pyramidLevels;
+                            for (uint32_t level = 0; level < pyramidLevelInfos.size(); level++) {
+                                pyramidLevels[level] = pyramidLevelInfos[level];
+                            }
+
+                            depthPyramidWriter.writeImage(0, &pyramidDepthInfo);
+                            depthPyramidWriter.writeImages(1, pyramidLevels);
+                            depthPyramidWriter.writeBuffer(2, &pyramidCounterInfo);
+
+                            depthPyramidWriter.overwrite(depthPyramidDescriptorSets[i]);
                         }
 
                         pointLightSystem.reconstructPipeline(bananRenderer.getGeometryRenderPass(), {globalSetLayout->getDescriptorSetLayout()});
                         computeSystem.reconstructPipeline({globalSetLayout->getDescriptorSetLayout()});
+                        depthPyramidSystem.reconstructPipeline({depthPyramidSetLayout->getDescriptorSetLayout()});
                         procrastinatedRenderSystem.reconstructPipeline(bananRenderer.getGeometryRenderPass(), {globalSetLayout->getDescriptorSetLayout(), textureSetLayout->getDescriptorSetLayout(), normalSetLayout->getDescriptorSetLayout(), heightMapSetLayout->getDescriptorSetLayout()}, {globalSetLayout->getDescriptorSetLayout(), procrastinatedSetLayout->getDescriptorSetLayout()});
                         resolveSystem.reconstructPipelines(bananRenderer.getEdgeDetectionRenderPass(), bananRenderer.getBlendWeightRenderPass(), bananRenderer.getResolveRenderPass(), {globalSetLayout->getDescriptorSetLayout(), edgeDetectionSetLayout->getDescriptorSetLayout()}, {globalSetLayout->getDescriptorSetLayout(), blendWeightSetLayout->getDescriptorSetLayout()}, {globalSetLayout->getDescriptorSetLayout(), resolveLayout->getDescriptorSetLayout()});
                     }
@@ -290,7 +373,7 @@ namespace Banan{
                     continue;
 
                 case SDL_QUIT:
-                    vkDeviceWaitIdle(bananDevice.device());
+                    bananDevice.waitIdle();
                     return;
             }
 
@@ -298,8 +381,8 @@ namespace Banan{
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
-            cameraController.moveInPlaneXZ(frameTime, viewerObject);
-            camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+            cameraController.moveInPlaneXZ(frameTime, viewerTransform);
+            camera.setViewYXZ(viewerTransform.translation, viewerTransform.rotation);
 
             float aspect = bananRenderer.getAspectRatio();
             camera.setOrthographicProjection(-aspect, aspect, -1, 1, -1, 1);
@@ -307,52 +390,9 @@ namespace Banan{
 
             if (auto commandBuffer = bananRenderer.beginFrame()) {
                 int frameIndex = bananRenderer.getFrameIndex();
-                BananFrameInfo frameInfo{frameIndex, frameTime, commandBuffer, camera, globalDescriptorSets[frameIndex], textureDescriptorSets[frameIndex], normalDescriptorSets[frameIndex], heightDescriptorSets[frameIndex], procrastinatedDescriptorSets[frameIndex], edgeDetectionDescriptorSets[frameIndex], blendWeightDescriptorSets[frameIndex], resolveDescriptorSets[frameIndex], gameObjects};
+                mipFeedback->collect(frameIndex);
 
-                // ok heres the plan to fix this, one descriptor has the buffer as a regular storage buffer, another has the buffer as a dynamic storage buffer, we write the buffer to both descriptors
-                // then we calculate the stuff in the comp shader, and finally we apply a execution to guarantee that the shader has finished execution before doing the actual rendering
-
-                std::vector<GameObjectData> data{};
-                data.reserve(gameObjects.size());
-                for (auto &kv : gameObjects) {
-                    if (kv.second.model != nullptr) {
-                        GameObjectData objectData{glm::vec4(kv.second.transform.translation, 0),
-                                                  glm::vec4(kv.second.transform.rotation,0),
-                                                  glm::vec4(kv.second.transform.scale, 0),
-                                                  kv.second.transform.mat4(),
-                                                  kv.second.transform.normalMatrix(),
-                                                  kv.second.model->isTextureLoaded() ? (int) kv.first : -1,
-                                                  kv.second.model->isNormalsLoaded() ? (int) kv.first : -1,
-                                                  kv.second.model->isHeightmapLoaded() ? (int) kv.first : -1,
-                                                  kv.second.parallax.heightscale,
-                                                  kv.second.parallax.parallaxBias,
-                                                  kv.second.parallax.numLayers,
-                                                  kv.second.parallax.parallaxmode,
-                                                  0
-                        };
-
-                        data.push_back(objectData);
-                    } else {
-                        GameObjectData pointLightData{glm::vec4(kv.second.transform.translation, 0),
-                                                      glm::vec4(kv.second.color, kv.second.pointLight->lightIntensity),
-                                                      glm::vec4(kv.second.transform.scale.x, -1, -1, -1),
-                                                      glm::mat4{1.f},
-                                                      glm::mat4{1.f},
-                                                      -1,
-                                                      -1,
-                                                      -1,
-                                                      -1,
-                                                      -1,
-                                                      -1,
-                                                      -1,
-                                                      1
-                        };
-
-                        data.push_back(pointLightData);
-                    }
-                }
-
-                std::reverse(data.begin(), data.end());
+                BananFrameInfo frameInfo{frameIndex, frameTime, commandBuffer, camera, globalDescriptorSets[frameIndex], textureDescriptorSets[frameIndex], normalDescriptorSets[frameIndex], heightDescriptorSets[frameIndex], procrastinatedDescriptorSets[frameIndex], edgeDetectionDescriptorSets[frameIndex], blendWeightDescriptorSets[frameIndex], resolveDescriptorSets[frameIndex], gameObjects};
 
                 GlobalUbo ubo{};
                 ubo.projection = camera.getProjection();
@@ -360,28 +400,26 @@ namespace Banan{
                 ubo.inverseView = camera.getInverseView();
                 ubo.inverseProjection = camera.getInverseProjection();
                 ubo.numGameObjects = gameObjects.size();
+                ubo.frameNumber = frameNumber++;
 
                 pointLightSystem.update(frameInfo);
                 uboBuffers[frameIndex]->writeToBuffer(&ubo);
                 uboBuffers[frameIndex]->flush();
 
-                storageBuffers[frameIndex]->writeToBuffer(data.data());
-                storageBuffers[frameIndex]->flush();
-
-//                computeSystem.compute(frameInfo);
-
-//                // ensure compute shader finishes work (it isnt working)
-//                VkBufferMemoryBarrier barrier;
-//                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-//                barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-//                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-//                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-//                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-//                barrier.buffer = storageBuffers[frameIndex]->getBuffer();
-//                barrier.size = storageBuffers[frameIndex]->getBufferSize();
-//                barrier.offset = 0;
-//
-//                vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,nullptr, 1, &barrier, 0, nullptr);
+                gameObjects.updateBuffer(frameIndex);
+                gameObjects.writeTextureDescriptors(frameIndex, textureDescriptorSets[frameIndex], normalDescriptorSets[frameIndex], heightDescriptorSets[frameIndex]);
+
+                // builds the matrices of every object the manager left to the gpu, and records the barrier before the geometry pass reads them
+                computeSystem.compute(frameInfo);
+                procrastinatedRenderSystem.cull(frameInfo);
+
+                // draws what was visible last frame, builds the depth pyramid from it and tests everything else against that
+                bananRenderer.beginEarlyGeometryRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                procrastinatedRenderSystem.renderEarlyGBuffer(frameInfo);
+                bananRenderer.endRenderPass(commandBuffer);
+
+                depthPyramidSystem.build(frameInfo, bananRenderer.getDepthPyramid(), depthPyramidDescriptorSets[frameIndex]);
+                procrastinatedRenderSystem.cullOccluded(frameInfo);
 
                 /*for (int i = 0; i < 6; i++) {
                     bananRenderer.beginShadowRenderPass(commandBuffer);
@@ -389,12 +427,15 @@ namespace Banan{
                     bananRenderer.endShadowRenderPass(commandBuffer, i);
                 }*/
 
-                bananRenderer.beginGeometryRenderPass(commandBuffer);
+                bananRenderer.beginGeometryRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
                 procrastinatedRenderSystem.calculateGBuffer(frameInfo);
                 procrastinatedRenderSystem.render(frameInfo);
                 pointLightSystem.render(frameInfo);
                 bananRenderer.endRenderPass(commandBuffer);
 
+                // the g-buffer passes are done writing mip feedback, collect reads it once this frame's fence signals
+                mipFeedback->recordReadback(commandBuffer);
+
                 bananRenderer.beginEdgeDetectionRenderPass(commandBuffer);
                 resolveSystem.runEdgeDetection(frameInfo);
                 bananRenderer.endRenderPass(commandBuffer);
@@ -442,53 +483,77 @@ namespace Banan{
 
         bananDevice.endSingleTimeCommands(commandBuffer);
 
-        BananModel::Builder vaseBuilder{};
-        vaseBuilder.loadModel("banan_assets/ceramic_vase_01_4k.blend");
-        vaseBuilder.loadTexture("banan_assets/textures/ceramic_vase_01_diff_4k.jpg");
-        vaseBuilder.loadNormals("banan_assets/textures/ceramic_vase_01_nor_gl_4k.exr");
+        // the hand built scene is written out on the first run, later runs just map it back in
+        BananSceneFile sceneFile{SCENE_PATH};
+        if (std::filesystem::exists(SCENE_PATH)) {
+            sceneFile.load(gameObjects, assetCache, jobSystem);
+        } else {
+            createDefaultScene();
+            sceneFile.save(gameObjects, assetCache);
+        }
+    }
+
+    void BananEngineTest::createDefaultScene() {
+        const TextureImportSettings albedo{BananModel::TextureType::ALBEDO, true, true};
+        const TextureImportSettings normal{BananModel::TextureType::NORMAL, true, true};
+        const TextureImportSettings height{BananModel::TextureType::HEIGHT, true, true};
+
+        // everything is decoded at once so the small textures can share atlas pages
+        assetCache.preload(jobSystem, {"banan_assets/ceramic_vase_01_4k.blend", "banan_assets/quad.obj"}, {
+                {"banan_assets/textures/ceramic_vase_01_diff_4k.jpg", albedo},
+                {"banan_assets/textures/ceramic_vase_01_nor_gl_4k.exr", normal},
+                {"banan_assets/textures/Tiles_046_basecolor.jpg", albedo},
+                {"banan_assets/textures/Tiles_046_normal.exr", normal},
+                {"banan_assets/textures/Tiles_046_height.png", height}
+        });
+
+        auto setMaterial = [&](BananGameObject &object, const std::string &texture, const std::string &normalMap, const std::string &heightMap) {
+            auto &material = object.add<MaterialComponent>();
+            if (!texture.empty()) {
+                BananAtlasRegion region = assetCache.loadTextureRegion(texture, albedo);
+                material.texture = region.page;
+                material.uvTransform = region.uvTransform;
+            }
+            if (!normalMap.empty()) {
+                BananAtlasRegion region = assetCache.loadTextureRegion(normalMap, normal);
+                material.normal = region.page;
+                material.normalUvTransform = region.uvTransform;
+            }
+            if (!heightMap.empty()) {
+                BananAtlasRegion region = assetCache.loadTextureRegion(heightMap, height);
+                material.height = region.page;
+                material.heightUvTransform = region.uvTransform;
+            }
+        };
+
+        auto vase = gameObjects.createGameObject();
+        vase.add<ModelComponent>({assetCache.loadModel("banan_assets/ceramic_vase_01_4k.blend")});
+        setMaterial(vase, "banan_assets/textures/ceramic_vase_01_diff_4k.jpg", "banan_assets/textures/ceramic_vase_01_nor_gl_4k.exr", "");
 
-        std::shared_ptr<BananModel> vaseModel = std::make_shared<BananModel>(bananDevice, vaseBuilder);
-        auto vase = BananGameObject::createGameObject();
-        vase.model = vaseModel;
-        vase.transform.translation = {0.f, .5f, 0.f};
-        vase.transform.rotation = {-glm::pi<float>() / 2.0f, 0.f, 0.0f};
-        vase.transform.scale = {3.f, 3.f, 3.f};
-        vase.transform.id = (int) vase.getId();
-        gameObjects.emplace(vase.getId(), std::move(vase));
+        vase.transform().translation = {0.f, .5f, 0.f};
+        vase.transform().rotation = {-glm::pi<float>() / 2.0f, 0.f, 0.0f};
+        vase.transform().scale = {3.f, 3.f, 3.f};
 
         /*BananModel::Builder otherfloorBuilder{};
         otherfloorBuilder.loadModel("banan_assets/obamium.blend");
         otherfloorBuilder.loadTexture("banan_assets/textures/base.png");
 
         std::shared_ptr<BananModel> otherfloorModel = std::make_shared<BananModel>(bananDevice, otherfloorBuilder);
-        auto otherfloor = BananGameObject::createGameObject();
-        otherfloor.model = otherfloorModel;
-        otherfloor.transform.translation = {0.f, .3f, 0.f};
-        otherfloor.transform.rotation = {glm::pi<float>() / 2.0f, 0.f, 0.f};
-        otherfloor.transform.scale = {1.f, 1.f, 1.f};
-        otherfloor.transform.id = (int) otherfloor.getId();
-        gameObjects.emplace(otherfloor.getId(), std::move(otherfloor));*/
-
-        BananModel::Builder floorBuilder{};
-        floorBuilder.loadModel("banan_assets/quad.obj");
-        floorBuilder.loadTexture("banan_assets/textures/Tiles_046_basecolor.jpg");
-        floorBuilder.loadNormals("banan_assets/textures/Tiles_046_normal.exr");
-        floorBuilder.loadHeightMap("banan_assets/textures/Tiles_046_height.png");
-
-        std::shared_ptr<BananModel> floorModel = std::make_shared<BananModel>(bananDevice, floorBuilder);
-        auto floor = BananGameObject::createGameObject();
-        floor.model = floorModel;
-        floor.transform.translation = {0.f, .5f, 0.f};
-        floor.transform.rotation = {0.f, glm::pi<float>(), 0.0f};
-        floor.transform.scale = {3.f, 3.f, 3.f};
-        floor.transform.id = (int) floor.getId();
-
-        floor.parallax.heightscale = 0.1;
-        floor.parallax.parallaxBias = -0.02f;
-        floor.parallax.numLayers = 48.0f;
-        floor.parallax.parallaxmode = 1;
-
-        gameObjects.emplace(floor.getId(), std::move(floor));
+        auto otherfloor = gameObjects.createGameObject();
+        otherfloor.add<ModelComponent>({otherfloorModel});
+        otherfloor.transform().translation = {0.f, .3f, 0.f};
+        otherfloor.transform().rotation = {glm::pi<float>() / 2.0f, 0.f, 0.f};
+        otherfloor.transform().scale = {1.f, 1.f, 1.f};*/
+
+        auto floor = gameObjects.createGameObject();
+        floor.add<ModelComponent>({assetCache.loadModel("banan_assets/quad.obj")});
+        setMaterial(floor, "banan_assets/textures/Tiles_046_basecolor.jpg", "banan_assets/textures/Tiles_046_normal.exr", "banan_assets/textures/Tiles_046_height.png");
+
+        floor.transform().translation = {0.f, .5f, 0.f};
+        floor.transform().rotation = {0.f, glm::pi<float>(), 0.0f};
+        floor.transform().scale = {3.f, 3.f, 3.f};
+
+        floor.add<ParallaxComponent>({0.1f, -0.02f, 48.0f, 1});
 
         std::vector<glm::vec3> lightColors{
                 {1.f, .1f, .1f},
@@ -500,35 +565,9 @@ namespace Banan{
         };
 
         for (size_t i = 0; i < lightColors.size(); i++) {
-            auto pointLight = BananGameObject::makePointLight(0.5f);
-            pointLight.color = lightColors[i];
+            auto pointLight = gameObjects.makePointLight(0.5f, 0.1f, lightColors[i]);
             auto rotateLight = glm::rotate(glm::mat4(1.f), (static_cast<float>(i) * glm::two_pi<float>()) / static_cast<float>(lightColors.size()), {0.f, -1.f, 0.f});
-            pointLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
-            pointLight.transform.id = 0;
-
-            pointLight.parallax.heightscale = -1;
-            pointLight.parallax.parallaxBias = -1;
-            pointLight.parallax.numLayers = -1;
-            pointLight.parallax.parallaxmode = -1;
-
-            gameObjects.emplace(pointLight.getId(), std::move(pointLight));
-        }
-
-        for (auto &kv : gameObjects)
-        {
-            if (kv.second.model != nullptr) {
-                if (kv.second.model->isTextureLoaded()) {
-                    gameObjectsTextureInfo.emplace(kv.first, kv.second.model->getDescriptorTextureImageInfo());
-                }
-
-                if (kv.second.model->isNormalsLoaded()) {
-                    gameObjectsNormalInfo.emplace(kv.first, kv.second.model->getDescriptorNormalImageInfo());
-                }
-
-                if (kv.second.model->isHeightmapLoaded()) {
-                    gameObjectsHeightInfo.emplace(kv.first, kv.second.model->getDescriptorHeightMapInfo());
-                }
-            }
+            pointLight.transform().translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
         }
     }
 
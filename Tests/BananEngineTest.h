@@ -10,6 +10,10 @@
 #include <banan_game_object.h>
 #include <banan_renderer.h>
 #include <banan_logger.h>
+#include <banan_mip_feedback.h>
+#include <banan_asset_cache.h>
+#include <banan_job_system.h>
+#include <banan_scene_file.h>
 
 #include <memory>
 #include <vector>
@@ -21,6 +25,8 @@ namespace Banan{
     public:
         static constexpr int WIDTH = 800;
         static constexpr int HEIGHT = 600;
+        static constexpr uint32_t MAX_GAME_OBJECTS = 1024;
+        static constexpr const char *SCENE_PATH = "banan_assets/scene.bscn";
 
         BananEngineTest(const BananEngineTest &) = delete;
         BananEngineTest &operator=(const BananEngineTest &) = delete;
@@ -32,10 +38,14 @@ namespace Banan{
         std::shared_ptr<BananLogger> getLogger();
     private:
         void loadGameObjects();
+        void createDefaultScene();
 
         BananWindow bananWindow{WIDTH, HEIGHT};
         BananDevice bananDevice{bananWindow};
-        BananRenderer bananRenderer{bananWindow, bananDevice};
+        BananJobSystem jobSystem{};
+        // every worker and the main thread can record secondary command buffers
+        BananRenderer bananRenderer{bananWindow, bananDevice, jobSystem.getWorkerCount() + 1};
+        BananAssetCache assetCache{bananDevice};
 
         std::unique_ptr<BananDescriptorPool> globalPool;
         std::unique_ptr<BananDescriptorPool> texturePool;
@@ -45,17 +55,16 @@ namespace Banan{
         std::unique_ptr<BananDescriptorPool> edgeDetectionPool;
         std::unique_ptr<BananDescriptorPool> blendWeightPool;
         std::unique_ptr<BananDescriptorPool> resolvePool;
+        std::unique_ptr<BananDescriptorPool> depthPyramidPool;
 
         std::shared_ptr<BananLogger> bananLogger;
-        BananGameObject::Map gameObjects;
-
-        std::unordered_map<uint32_t, VkDescriptorImageInfo> gameObjectsTextureInfo;
-        std::unordered_map<uint32_t, VkDescriptorImageInfo> gameObjectsNormalInfo;
-        std::unordered_map<uint32_t, VkDescriptorImageInfo> gameObjectsHeightInfo;
+        BananGameObjectManager gameObjects{bananDevice, MAX_GAME_OBJECTS};
 
         std::unordered_map<uint32_t, glm::mat4> gameObjectModelMatrices;
 
         std::unique_ptr<BananImage> areaTex;
         std::unique_ptr<BananImage> searchTex;
+
+        std::unique_ptr<BananMipFeedback> mipFeedback;
     };
 }
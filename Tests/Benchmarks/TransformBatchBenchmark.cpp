@@ -0,0 +1,96 @@
+#include <banan_game_object.h>
+#include <banan_transform_batch.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Banan;
+
+// times the per object TransformComponent matrices against BananTransformBatch over the same transforms.
+// usage: TransformBatchBenchmark [objects] [iterations]
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 100;
+    if (count == 0 || iterations <= 0) {
+        std::cout << "usage: TransformBatchBenchmark [objects] [iterations]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> position{-100.f, 100.f};
+    std::uniform_real_distribution<float> angle{-glm::pi<float>(), glm::pi<float>()};
+    std::uniform_real_distribution<float> size{0.1f, 4.f};
+
+    std::vector<TransformComponent> transforms(count);
+    for (auto &transform : transforms) {
+        transform.translation = {position(rng), position(rng), position(rng)};
+        transform.rotation = {angle(rng), angle(rng), angle(rng)};
+        transform.scale = {size(rng), size(rng), size(rng)};
+    }
+
+    std::vector<glm::mat4> scalarModels(count), batchModels(count);
+    std::vector<glm::mat3> scalarNormals(count), batchNormals(count);
+
+    // one untimed run first so page faults and cold caches don't land in the first sample
+    auto time = [iterations](auto &&function) {
+        function();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            function();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    };
+
+    double scalarTime = time([&] {
+        for (size_t i = 0; i < count; i++) {
+            scalarModels[i] = transforms[i].mat4();
+            scalarNormals[i] = transforms[i].normalMatrix();
+        }
+    });
+
+    BananTransformBatch batch;
+    batch.reserve(count);
+
+    // the engine refills the batch every frame, so that is timed too
+    double batchTime = time([&] {
+        batch.clear();
+        for (auto &transform : transforms) {
+            batch.push(transform);
+        }
+        batch.compute(batchModels.data(), batchNormals.data());
+    });
+
+    double computeTime = time([&] {
+        batch.compute(batchModels.data(), batchNormals.data());
+    });
+
+    float maxError = 0.f;
+    for (size_t i = 0; i < count; i++) {
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                maxError = std::max(maxError, std::abs(scalarModels[i][c][r] - batchModels[i][c][r]));
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            for (int r = 0; r < 3; r++) {
+                maxError = std::max(maxError, std::abs(scalarNormals[i][c][r] - batchNormals[i][c][r]));
+            }
+        }
+    }
+
+    std::cout << count << " objects, " << iterations << " iterations\n";
+    std::cout << "mat4() + normalMatrix():  " << scalarTime << " ms\n";
+    std::cout << "batch push + compute:     " << batchTime << " ms (" << scalarTime / batchTime << "x)\n";
+    std::cout << "batch compute:            " << computeTime << " ms (" << scalarTime / computeTime << "x)\n";
+    std::cout << "max abs difference:       " << maxError << "\n";
+
+    return EXIT_SUCCESS;
+}
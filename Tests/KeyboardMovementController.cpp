@@ -8,7 +8,7 @@
 #include <iostream>
 
 namespace Banan {
-    void KeyboardMovementController::moveInPlaneXZ(float dt, Banan::BananGameObject &object) {
+    void KeyboardMovementController::moveInPlaneXZ(float dt, TransformComponent &transform) {
         glm::vec3 rotate{0.f};
         glm::vec3 moveDir{0.f};
 
@@ -32,13 +32,13 @@ namespace Banan {
         }
 
         if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
-            object.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+            transform.rotation += lookSpeed * dt * glm::normalize(rotate);
         }
 
-        object.transform.rotation.x = glm::clamp(object.transform.rotation.x, -1.5f, 1.5f);
-        object.transform.rotation.y = glm::mod(object.transform.rotation.y, glm::two_pi<float>());
+        transform.rotation.x = glm::clamp(transform.rotation.x, -1.5f, 1.5f);
+        transform.rotation.y = glm::mod(transform.rotation.y, glm::two_pi<float>());
 
-        float yaw = object.transform.rotation.y;
+        float yaw = transform.rotation.y;
         const glm::vec3 forwardDir{sin(yaw), 0.f, cos(yaw)};
         const glm::vec3 rightDir{forwardDir.z, 0.f, -forwardDir.x};
         const glm::vec3 upDir{0.f, -1.f, 0.f};
@@ -68,7 +68,7 @@ namespace Banan {
         }
 
         if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
-            object.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+            transform.translation += moveSpeed * dt * glm::normalize(moveDir);
         }
     }
 }
@@ -26,7 +26,7 @@ namespace Banan {
             int lookDown = SDL_SCANCODE_DOWN;
         };
 
-        void moveInPlaneXZ(float dt, BananGameObject &object);
+        void moveInPlaneXZ(float dt, TransformComponent &transform);
 
         float moveSpeed{3.f};
         float lookSpeed{1.5f};
@@ -0,0 +1,74 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_GOOGLE_include_directive : require
+
+layout (location = 1) in vec2 fragTexCoord;
+layout (location = 3) in vec3 fragNormal;
+layout (location = 4) in vec4 fragPosWorld;
+layout (location = 6) flat in int fragObjectId;
+
+struct GameObject {
+    vec4 position;
+    vec4 rotation; // color for point lights
+    vec4 scale; // radius for point lights
+    vec4 uvTransform; // xy scale, zw offset of the albedo texture inside an atlas page
+    vec4 normalUvTransform; // same for the normal and height maps, which can sit in pages of their own
+    vec4 heightUvTransform;
+
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+
+    int textureLocation;
+    int normalLocation;
+
+    int heightLocation;
+    float heightscale;
+    float parallaxBias;
+    float numLayers;
+    int parallaxmode;
+
+    int isPointLight;
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 inverseProjection;
+    mat4 view;
+    mat4 inverseView;
+    vec4 ambientLightColor;
+} ubo;
+
+layout(set = 0, binding = 1) readonly buffer GameObjects {
+    GameObject objects[];
+} ssbo;
+
+layout(set = 3, binding = 0) uniform sampler2D heightSampler[];
+
+#include "parallax.glsl"
+
+// depth only, the pipeline writes no color. discards exactly what gbuffer.frag cuts off, so the equal test there finds depth
+// on every fragment it keeps and on nothing else
+void main() {
+    vec2 uv = fragTexCoord;
+    int parallaxmode = ssbo.objects[fragObjectId].parallaxmode;
+    if (parallaxmode == 1 || parallaxmode == 2) {
+        vec3 nrmBaseNormal = normalize(mat3(ssbo.objects[fragObjectId].normalMatrix) * fragNormal);
+        vec3 dPdx = dFdxFine(fragPosWorld.xyz);
+        vec3 dPdy = dFdyFine(fragPosWorld.xyz);
+        vec3 viewDirection = normalize(ubo.inverseView[3].xyz - fragPosWorld.xyz);
+
+        vec2 projV = projectVecToTextureSpace(viewDirection, fragTexCoord, ssbo.objects[fragObjectId].heightscale, parallaxmode == 1, dPdx, dPdy, nrmBaseNormal);
+        float lod = heightMapLod(fragTexCoord, fragObjectId);
+
+        // the offset can't reach past projV, so fragments further than that from every edge are kept whatever the height map
+        // says and only the rim that can actually be cut off pays for the height taps
+        vec2 reach = abs(projV) * (parallaxmode == 1 ? 0.5 : 1.0);
+        if (any(lessThan(fragTexCoord, reach)) || any(greaterThan(fragTexCoord, 1.0 - reach))) {
+            uv = parallaxmode == 1 ? parallaxMapping(fragTexCoord, projV, fragObjectId) : parallaxOcclusionMapping(fragTexCoord, projV, lod);
+        }
+    }
+
+    if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) {
+        discard;
+    }
+}
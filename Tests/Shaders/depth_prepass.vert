@@ -0,0 +1,64 @@
+#version 450
+
+// the position stream plus the normal and uv the parallax cut-off needs, the color is never fetched
+layout (location = 0) in vec3 position;
+layout (location = 2) in vec3 normal;
+layout (location = 4) in vec2 uv;
+
+layout (location = 1) out vec2 fragTexCoord;
+layout (location = 3) out vec3 fragNormal;
+layout (location = 4) out vec4 fragPosWorld;
+layout (location = 6) flat out int fragObjectId;
+
+struct GameObject {
+    vec4 position;
+    vec4 rotation; // color for point lights
+    vec4 scale; // radius for point lights
+    vec4 uvTransform; // xy scale, zw offset of the albedo texture inside an atlas page
+    vec4 normalUvTransform; // same for the normal and height maps, which can sit in pages of their own
+    vec4 heightUvTransform;
+
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+
+    int textureLocation;
+    int normalLocation;
+
+    int heightLocation;
+    float heightscale;
+    float parallaxBias;
+    float numLayers;
+    int parallaxmode;
+
+    int isPointLight;
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 inverseProjection;
+    mat4 view;
+    mat4 inverseView;
+    vec4 ambientLightColor;
+} ubo;
+
+layout(set = 0, binding = 1) readonly buffer GameObjects {
+    GameObject objects[];
+} ssbo;
+
+layout(set = 0, binding = 3) readonly buffer Instances {
+    uint objectIds[];
+} instances;
+
+// the g-buffer pass tests for equal depth against this, so the position has to come out bit for bit the same as gbuffer.vert's
+invariant gl_Position;
+
+void main() {
+    int objectId = int(instances.objectIds[gl_InstanceIndex]);
+    fragObjectId = objectId;
+
+    fragPosWorld = ssbo.objects[objectId].modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * fragPosWorld;
+
+    fragTexCoord = uv;
+    fragNormal = normal;
+}
@@ -13,6 +13,7 @@ layout (location = 2) out vec3 fragPos;
 layout (location = 3) out vec3 fragNormal;
 layout (location = 4) out vec4 fragPosWorld;
 layout (location = 5) out vec3 fragTangent;
+layout (location = 6) flat out int fragObjectId;
 
 struct PointLight {
     vec4 position;
@@ -23,14 +24,17 @@ struct GameObject {
     vec4 position;
     vec4 rotation; // color for point lights
     vec4 scale; // radius for point lights
+    vec4 uvTransform; // xy scale, zw offset of the albedo texture inside an atlas page
+    vec4 normalUvTransform; // same for the normal and height maps, which can sit in pages of their own
+    vec4 heightUvTransform;
 
     mat4 modelMatrix;
     mat4 normalMatrix;
 
-    int hasTexture;
-    int hasNormal;
+    int textureLocation;
+    int normalLocation;
 
-    int hasHeight;
+    int heightLocation;
     float heightscale;
     float parallaxBias;
     float numLayers;
@@ -51,12 +55,19 @@ layout(set = 0, binding = 1) readonly buffer GameObjects {
     GameObject objects[];
 } ssbo;
 
-layout(push_constant) uniform Push {
-    int objectId;
-} push;
+// one entry per instance, cull.comp packs the visible objects of each model into a run and the draw's firstInstance points at it
+layout(set = 0, binding = 3) readonly buffer Instances {
+    uint objectIds[];
+} instances;
+
+// depth_prepass.vert has to produce the exact same position for the equal depth test
+invariant gl_Position;
 
 void main() {
-    fragPosWorld = ssbo.objects[push.objectId].modelMatrix * vec4(position, 1.0);
+    int objectId = int(instances.objectIds[gl_InstanceIndex]);
+    fragObjectId = objectId;
+
+    fragPosWorld = ssbo.objects[objectId].modelMatrix * vec4(position, 1.0);
     gl_Position = ubo.projection * ubo.view * fragPosWorld;
 
     fragTexCoord = uv;
@@ -6,6 +6,9 @@ struct GameObject {
     vec4 position;
     vec4 rotation; // color for point lights
     vec4 scale; // radius for point lights
+    vec4 uvTransform; // xy scale, zw offset of the albedo texture inside an atlas page
+    vec4 normalUvTransform; // same for the normal and height maps, which can sit in pages of their own
+    vec4 heightUvTransform;
 
     mat4 modelMatrix;
     mat4 normalMatrix;
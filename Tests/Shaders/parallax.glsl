@@ -0,0 +1,138 @@
+// parallax shared by gbuffer.frag and depth_prepass.frag, which both have to cut off exactly the same fragments. the
+// including shader declares ssbo, heightSampler and fragObjectId. everything that takes derivatives is done by the caller,
+// so the offsets can also run in control flow that isn't uniform
+
+// atlased maps sit at transform inside a page. the uv is wrapped first so tiling repeats the sub-image instead of walking
+// into its neighbours, so gradients and lods have to come from the unwrapped uv scaled by transform.xy. identity transforms
+// are left to the sampler's own addressing
+vec2 atlasUV(vec2 uv, vec4 transform)
+{
+    return transform == vec4(1.0, 1.0, 0.0, 0.0) ? uv : fract(uv) * transform.xy + transform.zw;
+}
+
+// the mip occlusion mapping marches on, taken from the unwrapped uv like the other lods
+float heightMapLod(vec2 uv, int index)
+{
+    return textureQueryLod(heightSampler[nonuniformEXT(ssbo.objects[index].heightLocation)], uv * ssbo.objects[index].heightUvTransform.xy).y;
+}
+
+vec2 RayMarch(vec2 st0_in, vec2 st1_in, float lod_base)
+{
+    vec4 heightTransform = ssbo.objects[fragObjectId].heightUvTransform;
+    vec2 dims = textureSize(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], 0) * heightTransform.xy;
+    float distInPix = length(dims * (st1_in-st0_in));
+
+    const int iterations = 3;
+    vec3 st0 = vec3(st0_in, 0.0);
+    vec3 st1 = vec3(st1_in, -1.0);
+
+    float nrStepsAlongRay = ssbo.objects[fragObjectId].numLayers;			// very brute-force
+    float scale = ssbo.objects[fragObjectId].heightscale;
+
+    float nrInnerIts = (nrStepsAlongRay + 7) / 8;
+
+    float t0 = 0.0, t1 = 1.0;
+    for(int i = 0; i < iterations; i++)
+    {
+        bool notStopped = true;
+        int j = 0;
+
+        while(notStopped && j < nrInnerIts)
+        {
+            float T1 = mix(t0, t1, clamp((j*8+1)*scale, 0.0, 1.0) );
+            float T2 = mix(t0, t1, clamp((j*8+2)*scale, 0.0, 1.0) );
+            float T3 = mix(t0, t1, clamp((j*8+3)*scale, 0.0, 1.0) );
+            float T4 = mix(t0, t1, clamp((j*8+4)*scale, 0.0, 1.0) );
+            float T5 = mix(t0, t1, clamp((j*8+5)*scale, 0.0, 1.0) );
+            float T6 = mix(t0, t1, clamp((j*8+6)*scale, 0.0, 1.0) );
+            float T7 = mix(t0, t1, clamp((j*8+7)*scale, 0.0, 1.0) );
+            float T8 = mix(t0, t1, clamp((j*8+8)*scale, 0.0, 1.0) );
+
+            float h1 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, T1).xy, heightTransform), lod_base).r - 1.0;
+            float h2 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, T2).xy, heightTransform), lod_base).r - 1.0;
+            float h3 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, T3).xy, heightTransform), lod_base).r - 1.0;
+            float h4 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, T4).xy, heightTransform), lod_base).r - 1.0;
+            float h5 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, T5).xy, heightTransform), lod_base).r - 1.0;
+            float h6 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, T6).xy, heightTransform), lod_base).r - 1.0;
+            float h7 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, T7).xy, heightTransform), lod_base).r - 1.0;
+            float h8 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, T8).xy, heightTransform), lod_base).r - 1.0;
+
+            float t_s = t0, t_e = t1;
+
+            if(notStopped) { if( mix(st0, st1, T1).z >= h1 ) { t_s = T1; } else { t_e = T1; notStopped=false; } }
+            if(notStopped) { if( mix(st0, st1, T2).z >= h2 ) { t_s = T2; } else { t_e = T2; notStopped=false; } }
+            if(notStopped) { if( mix(st0, st1, T3).z >= h3 ) { t_s = T3; } else { t_e = T3; notStopped=false; } }
+            if(notStopped) { if( mix(st0, st1, T4).z >= h4 ) { t_s = T4; } else { t_e = T4; notStopped=false; } }
+            if(notStopped) { if( mix(st0, st1, T5).z >= h5 ) { t_s = T5; } else { t_e = T5; notStopped=false; } }
+            if(notStopped) { if( mix(st0, st1, T6).z >= h6 ) { t_s = T6; } else { t_e = T6; notStopped=false; } }
+            if(notStopped) { if( mix(st0, st1, T7).z >= h7 ) { t_s = T7; } else { t_e = T7; notStopped=false; } }
+            if(notStopped) { if( mix(st0, st1, T8).z >= h8 ) { t_s = T8; } else { t_e = T8; notStopped=false; } }
+
+            t0 = t_s; t1 = t_e;
+            notStopped = notStopped && t0 < t1;
+
+            ++j;
+        }
+
+        // update number of taps along ray we allow
+        nrStepsAlongRay = int(clamp(4 * distInPix * abs(t1 - t0), 8, 16));
+        scale = 1.0 / float(nrStepsAlongRay);
+        nrInnerIts = (nrStepsAlongRay + 7) / 8;
+
+        ++i;
+    }
+
+    float h0 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, t0).xy, heightTransform), lod_base).r - 1.0;
+    float h1 = textureLod(heightSampler[nonuniformEXT(ssbo.objects[fragObjectId].heightLocation)], atlasUV(mix(st0, st1, t1).xy, heightTransform), lod_base).r - 1.0;
+    float ray_h0 = mix(st0, st1, t0).z;
+    float ray_h1 = mix(st0, st1, t1).z;
+
+    vec3 eqR = vec3(-(ray_h1 - ray_h0), t1 - t0, 0.0);
+    eqR.z = -dot(eqR.xy, vec2(0.0, ray_h0));		// 0.0 corresponds to t0
+
+    vec3 eqT = vec3(-(h1 - h0), t1 - t0, 0.0);
+    eqT.z = -dot(eqT.xy, vec2(0.0, h0));					// 0.0 corresponds to t0
+
+    const float eps = 1.192093e-15F;
+    float determ = eqR.x * eqT.y - eqR.y * eqT.x;
+    determ = (determ < 0.0 ? -1.0 : 1.0) * max(eps, abs(determ));
+
+    //Ar*t + Br*h  = -Cr
+    //At*t + Bt*h  = -Ct
+
+    float finalT = clamp(t0 + ((eqT.y * (-eqR.z) + (-eqR.y) * (-eqT.z)) / determ), 0.0, 1.0);
+
+    //float finalT = saturate(0.5*(t0+t1));
+    return mix(st0_in, st1_in, finalT).xy - st0_in;
+}
+
+vec2 projectVecToTextureSpace(vec3 dir, vec2 texST, float bumpScale, bool skipProj, vec3 dPdx, vec3 dPdy, vec3 nrmBaseNormal)
+{
+    vec2 texDx = dFdx(texST);
+    vec2 texDy = dFdy(texST);
+    vec3 vR1 = cross(dPdy, nrmBaseNormal);
+    vec3 vR2 = cross(nrmBaseNormal, dPdx);
+    float det = dot(dPdx, vR1);
+    const float eps = 1.192093e-15F;
+    float sgn = det < 0.0 ? -1.0 : 1.0;
+    float s = sgn / max(eps, abs(det));
+    vec2 dirScr = s * vec2(dot(vR1, dir), dot(vR2, dir));
+    vec2 dirTex = texDx * dirScr.x + texDy*dirScr.y;
+    float dirTexZ = dot(nrmBaseNormal, dir);
+    s = skipProj ? 1.0 : 1.0 / max(eps, abs(dirTexZ));
+    return s * bumpScale * dirTex;
+}
+
+// both offsets move uv along projV, offset mapping by at most half of it and occlusion mapping by at most all of it
+vec2 parallaxMapping(vec2 uv, vec2 projV, int index)
+{
+    float height = textureLod(heightSampler[nonuniformEXT(ssbo.objects[index].heightLocation)], atlasUV(uv, ssbo.objects[index].heightUvTransform), 0.0).r - 0.5;
+    vec2 p = height * projV;
+    return uv + p;
+}
+
+vec2 parallaxOcclusionMapping(vec2 uv, vec2 projV, float lod)
+{
+    vec2 p = RayMarch(uv, uv + projV, lod);
+    return uv + p;
+}
@@ -1,12 +1,16 @@
 #version 450
 
 layout (location = 0) in vec2 fragOffset;
+layout (location = 1) flat in int fragObjectId;
 layout (location = 0) out vec4 outColor;
 
 struct GameObject {
     vec4 position;
     vec4 rotation; // color for point lights
     vec4 scale; // radius for point lights
+    vec4 uvTransform; // xy scale, zw offset of the albedo texture inside an atlas page
+    vec4 normalUvTransform; // same for the normal and height maps, which can sit in pages of their own
+    vec4 heightUvTransform;
 
     mat4 modelMatrix;
     mat4 normalMatrix;
@@ -27,6 +31,7 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 projection;
     mat4 inverseProjection;
     mat4 view;
+    mat4 inverseView;
     vec4 ambientLightColor;
     int numGameObjects;
 } ubo;
@@ -35,10 +40,6 @@ layout(set = 0, binding = 1) readonly buffer GameObjects {
     GameObject objects[];
 } ssbo;
 
-layout(push_constant) uniform Push {
-    int objectId;
-} push;
-
 const float PI = 3.1415926535897932384626433832795;
 
 void main() {
@@ -49,5 +50,5 @@ void main() {
     }
 
     float cosDis = 0.5 * (cos(dis * PI) + 1.0);
-    outColor = vec4(ssbo.objects[push.objectId].rotation.xyz + cosDis, cosDis);
+    outColor = vec4(ssbo.objects[fragObjectId].rotation.xyz + cosDis, cosDis);
 }
\ No newline at end of file
@@ -10,6 +10,7 @@ const vec2 OFFSETS[6] = vec2[](
 );
 
 layout (location = 0) out vec2 fragOffset;
+layout (location = 1) flat out int fragObjectId;
 
 struct PointLight {
   vec4 position;
@@ -20,6 +21,9 @@ struct GameObject {
   vec4 position;
   vec4 rotation; // color for point lights
   vec4 scale; // radius for point lights
+  vec4 uvTransform; // xy scale, zw offset of the albedo texture inside an atlas page
+  vec4 normalUvTransform; // same for the normal and height maps, which can sit in pages of their own
+  vec4 heightUvTransform;
 
   mat4 modelMatrix;
   mat4 normalMatrix;
@@ -40,6 +44,7 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   mat4 projection;
   mat4 inverseProjection;
   mat4 view;
+  mat4 inverseView;
   vec4 ambientLightColor;
   int numGameObjects;
 } ubo;
@@ -48,15 +53,19 @@ layout(set = 0, binding = 1) readonly buffer GameObjects {
   GameObject objects[];
 } ssbo;
 
-layout(push_constant) uniform Push {
-  int objectId;
-} push;
+// object id per instance, back to front
+layout(set = 0, binding = 9) readonly buffer Lights {
+  uint objectIds[];
+} lights;
 
 void main() {
+  int objectId = int(lights.objectIds[gl_InstanceIndex]);
+  fragObjectId = objectId;
+
   fragOffset = OFFSETS[gl_VertexIndex];
   vec3 cameraRightWorld = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
   vec3 cameraUpWorld = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
 
-  vec3 positionWorld = ssbo.objects[push.objectId].position.xyz + ssbo.objects[push.objectId].scale.r * fragOffset.x * cameraRightWorld + ssbo.objects[push.objectId].scale.r * fragOffset.y * cameraUpWorld;
+  vec3 positionWorld = ssbo.objects[objectId].position.xyz + ssbo.objects[objectId].scale.r * fragOffset.x * cameraRightWorld + ssbo.objects[objectId].scale.r * fragOffset.y * cameraUpWorld;
   gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
 }
\ No newline at end of file
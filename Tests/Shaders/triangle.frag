@@ -4,6 +4,11 @@
 #define EPSILON 0.15
 #define SHADOW_OPACITY 0.5
 
+// compile with -DMIP_FEEDBACK to record sampled mip levels, needs the feedback buffer bound at set 0 binding 2
+#ifdef MIP_FEEDBACK
+#define MIP_FEEDBACK_PATTERN 4u
+#endif
+
 layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec2 fragTexCoord;
 layout (location = 2) in vec3 fragPos;
@@ -17,6 +22,9 @@ struct GameObject {
     vec4 position;
     vec4 rotation; // color for point lights
     vec4 scale; // radius for point lights
+    vec4 uvTransform; // xy scale, zw offset of the albedo texture inside an atlas page
+    vec4 normalUvTransform; // same for the normal and height maps, which can sit in pages of their own
+    vec4 heightUvTransform;
 
     mat4 modelMatrix;
     mat4 normalMatrix;
@@ -40,12 +48,19 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
     mat4 inverseView;
     vec4 ambientLightColor;
     int numGameObjects;
+    int frameNumber;
 } ubo;
 
 layout(set = 0, binding = 1) readonly buffer GameObjects {
     GameObject objects[];
 } ssbo;
 
+#ifdef MIP_FEEDBACK
+layout(set = 0, binding = 2) buffer MipFeedback {
+    uint requiredMip[];
+} feedback;
+#endif
+
 layout(push_constant) uniform Push {
     int objectId;
 } push;
@@ -55,6 +70,17 @@ layout(set = 1, binding = 0) uniform sampler2D texSampler[];
 layout(set = 2, binding = 0) uniform sampler2D normalSampler[];
 layout(set = 3, binding = 0) uniform sampler2D heightSampler[];
 
+#ifdef MIP_FEEDBACK
+// records the finest mip sampled per texture on one pixel of every block, the block offset rotates each frame
+void writeMipFeedback(int index, float mipLevel)
+{
+    uvec2 cell = uvec2(gl_FragCoord.xy) % MIP_FEEDBACK_PATTERN;
+    if (cell.x + cell.y * MIP_FEEDBACK_PATTERN == uint(ubo.frameNumber) % (MIP_FEEDBACK_PATTERN * MIP_FEEDBACK_PATTERN)) {
+        atomicMin(feedback.requiredMip[index], uint(mipLevel));
+    }
+}
+#endif
+
 vec2 RayMarch(vec2 st0_in, vec2 st1_in)
 {
     float lod_base = textureQueryLod(heightSampler[push.objectId], st0_in).y;
@@ -172,8 +198,9 @@ vec3 getFinalNormal(vec2 inUV, vec3 dPdx, vec3 dPdy, vec3 nrmBaseNormal)
     vec3 vT = fragTangent;
     vec3 vB = cross(nrmBaseNormal, vT);
 
-    // tangent space normal
-    vec3 vM = textureLod(normalSampler[push.objectId], inUV, 0.0).rgb * 2.0 - 1.0;
+    // tangent space normal, stored as rg so z is reconstructed
+    vec2 vMxy = textureLod(normalSampler[push.objectId], inUV, 0.0).rg * 2.0 - 1.0;
+    vec3 vM = vec3(vMxy, sqrt(max(1.0 - dot(vMxy, vMxy), 0.0)));
 
     vec3 vMa = abs(vM);
     float z_ma = max(vMa.z, max(vMa.x, vMa.y));
@@ -226,7 +253,11 @@ void main() {
 
     vec3 color = fragColor;
     if (textureQueryLevels(texSampler[push.objectId]) > 0) {
-        color = texture(texSampler[push.objectId], uv).rgb;
+        vec2 albedoUV = uv * ssbo.objects[push.objectId].uvTransform.xy + ssbo.objects[push.objectId].uvTransform.zw;
+        color = texture(texSampler[push.objectId], albedoUV).rgb;
+#ifdef MIP_FEEDBACK
+        writeMipFeedback(push.objectId, textureQueryLod(texSampler[push.objectId], albedoUV).x);
+#endif
     }
 
     vec3 surfaceNormal = normalize(mat3(ssbo.objects[push.objectId].normalMatrix) * fragNormal);
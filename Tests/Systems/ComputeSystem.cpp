@@ -29,17 +29,32 @@ namespace Banan {
     }
 
     void ComputeSystem::createPipelines() {
+        bananPipelines.clear();
+
         PipelineConfigInfo pipelineConfig{};
         pipelineConfig.pipelineLayout = pipelineLayout;
         bananPipelines.push_back(std::make_shared<BananPipeline>(bananDevice, "shaders/calc_normal_mats.comp.spv", pipelineConfig));
     }
 
     void ComputeSystem::compute(BananFrameInfo &frameInfo) {
+        uint32_t groupCount = (frameInfo.gameObjects.size() + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+        if (groupCount == 0) {
+            return;
+        }
+
         for (auto pipeline : bananPipelines) {
             pipeline->bind(frameInfo.commandBuffer);
             vkCmdBindDescriptorSets(frameInfo.commandBuffer,VK_PIPELINE_BIND_POINT_COMPUTE,pipelineLayout,0,1,&frameInfo.globalDescriptorSet,0,nullptr);
-            vkCmdDispatch(frameInfo.commandBuffer, (frameInfo.gameObjects.size() / 256) + 1, 1, 1);
+            vkCmdDispatch(frameInfo.commandBuffer, groupCount, 1, 1);
         }
+
+        // the matrices are read by the cull pass and the vertex shaders and the object records by the fragment shaders, all have to wait for the writes
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(frameInfo.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
     }
 
     void ComputeSystem::reconstructPipeline(std::vector<VkDescriptorSetLayout> layouts) {
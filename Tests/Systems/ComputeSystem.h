@@ -11,6 +11,9 @@
 namespace Banan {
     class ComputeSystem {
         public:
+            // must match local_size_x in calc_normal_mats.comp
+            static constexpr uint32_t WORKGROUP_SIZE = 256;
+
             ComputeSystem(const ComputeSystem &) = delete;
             ComputeSystem &operator=(const ComputeSystem &) = delete;
 
@@ -0,0 +1,79 @@
+#include "DepthPyramidSystem.h"
+
+#include <stdexcept>
+
+namespace Banan {
+    DepthPyramidSystem::DepthPyramidSystem(BananDevice &device, std::vector<VkDescriptorSetLayout> layouts) : bananDevice{device} {
+        createPipelineLayout(layouts);
+        createPipeline();
+    }
+
+    DepthPyramidSystem::~DepthPyramidSystem() {
+        vkDestroyPipelineLayout(bananDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void DepthPyramidSystem::createPipelineLayout(std::vector<VkDescriptorSetLayout> layouts) {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(PushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
+        pipelineLayoutInfo.pSetLayouts = layouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(bananDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void DepthPyramidSystem::createPipeline() {
+        PipelineConfigInfo pipelineConfig{};
+        pipelineConfig.pipelineLayout = pipelineLayout;
+        bananPipeline = std::make_unique<BananPipeline>(bananDevice, "shaders/depth_pyramid.comp.spv", pipelineConfig);
+    }
+
+    void DepthPyramidSystem::build(BananFrameInfo &frameInfo, BananDepthPyramid &pyramid, VkDescriptorSet pyramidSet) {
+        // the early pass's depth and g-buffer writes have to land before the depth is read here and before the geometry pass
+        // loads the attachments again. the pyramid is shared by every frame, so last frame's occlusion test has to be done too
+        VkMemoryBarrier attachmentBarrier{};
+        attachmentBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        attachmentBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        attachmentBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        vkCmdPipelineBarrier(frameInfo.commandBuffer, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 1, &attachmentBarrier, 0, nullptr, 0, nullptr);
+
+        VkExtent2D extent = pyramid.getExtent();
+
+        PushConstants push{};
+        push.depthSize = {pyramid.getDepthExtent().width, pyramid.getDepthExtent().height};
+        push.pyramidSize = {extent.width, extent.height};
+        push.levelCount = pyramid.getLevelCount();
+
+        uint32_t groupsX = (extent.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        uint32_t groupsY = (extent.height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        push.groupCount = groupsX * groupsY;
+
+        bananPipeline->bind(frameInfo.commandBuffer);
+        vkCmdBindDescriptorSets(frameInfo.commandBuffer,VK_PIPELINE_BIND_POINT_COMPUTE,pipelineLayout,0,1,&pyramidSet,0,nullptr);
+        vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &push);
+        vkCmdDispatch(frameInfo.commandBuffer, groupsX, groupsY, 1);
+
+        // the occlusion test reads the pyramid, and the geometry pass must not write depth until the reads above are done
+        VkMemoryBarrier pyramidBarrier{};
+        pyramidBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(frameInfo.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 0, 1, &pyramidBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    void DepthPyramidSystem::reconstructPipeline(std::vector<VkDescriptorSetLayout> layouts) {
+        vkDestroyPipelineLayout(bananDevice.device(), pipelineLayout, nullptr);
+
+        createPipelineLayout(layouts);
+        createPipeline();
+    }
+}
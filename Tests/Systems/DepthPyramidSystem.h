@@ -0,0 +1,41 @@
+#pragma once
+
+#include <banan_pipeline.h>
+#include <banan_device.h>
+#include <banan_depth_pyramid.h>
+#include <banan_frame_info.h>
+
+namespace Banan {
+    class DepthPyramidSystem {
+        public:
+            // must match local_size_x and local_size_y in depth_pyramid.comp, each workgroup covers twice that of level 0
+            static constexpr uint32_t WORKGROUP_SIZE = 16;
+            static constexpr uint32_t BLOCK_SIZE = WORKGROUP_SIZE * 2;
+
+            DepthPyramidSystem(const DepthPyramidSystem &) = delete;
+            DepthPyramidSystem &operator=(const DepthPyramidSystem &) = delete;
+
+            DepthPyramidSystem(BananDevice &device, std::vector<VkDescriptorSetLayout> layouts);
+            ~DepthPyramidSystem();
+
+            // rebuilds every level from the depth the early geometry pass just wrote, in one dispatch. the set holds the
+            // depth attachment, the level views and the counter of the pyramid
+            void build(BananFrameInfo &frameInfo, BananDepthPyramid &pyramid, VkDescriptorSet pyramidSet);
+            void reconstructPipeline(std::vector<VkDescriptorSetLayout> layouts);
+
+        private:
+            struct PushConstants {
+                glm::uvec2 depthSize;
+                glm::uvec2 pyramidSize;
+                uint32_t levelCount;
+                uint32_t groupCount;
+            };
+
+            void createPipelineLayout(std::vector<VkDescriptorSetLayout> layouts);
+            void createPipeline();
+
+            BananDevice &bananDevice;
+            std::unique_ptr<BananPipeline> bananPipeline;
+            VkPipelineLayout pipelineLayout;
+    };
+}
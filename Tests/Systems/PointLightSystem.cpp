@@ -11,11 +11,15 @@
 
 #include <array>
 #include <cassert>
-#include <map>
 #include <stdexcept>
 
 namespace Banan{
-    PointLightSystem::PointLightSystem(BananDevice &device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> layouts) : bananDevice{device} {
+    PointLightSystem::PointLightSystem(BananDevice &device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> layouts, uint32_t maxLights) : bananDevice{device}, maxLights{maxLights} {
+        for (int i = 0; i < BananSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+            lightBuffers[i] = std::make_unique<BananBuffer>(bananDevice, sizeof(uint32_t), maxLights, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            lightBuffers[i]->map();
+        }
+
         createPipelineLayout(layouts);
         createPipeline(renderPass);
     }
@@ -24,19 +28,17 @@ namespace Banan{
         vkDestroyPipelineLayout(bananDevice.device(), pipelineLayout, nullptr);
     }
 
-    void PointLightSystem::createPipelineLayout(std::vector<VkDescriptorSetLayout> layouts) {
-
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(BananGameObject::id_t);
+    VkDescriptorBufferInfo PointLightSystem::getLightBufferInfo(int frameIndex) {
+        return lightBuffers[frameIndex]->descriptorInfo();
+    }
 
+    void PointLightSystem::createPipelineLayout(std::vector<VkDescriptorSetLayout> layouts) {
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
         pipelineLayoutInfo.pSetLayouts = layouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
         if (vkCreatePipelineLayout(bananDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
@@ -59,14 +61,37 @@ namespace Banan{
     }
 
     void PointLightSystem::render(BananFrameInfo &frameInfo) {
-        std::map<float, BananGameObject::id_t> sorted;
-        for (auto &kv : frameInfo.gameObjects) {
-            auto &obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
+        auto &bvh = frameInfo.gameObjects.getBvh();
+        auto &lights = frameInfo.gameObjects.pool<PointLightComponent>();
+        auto &transforms = frameInfo.gameObjects.pool<TransformComponent>();
+
+        cullingBatch.clear();
+        for (auto id : lights.ids()) {
+            if (bvh.contains(id)) {
+                cullingBatch.push(id, BananSphere{bvh.getBounds(id).center(), transforms.get(id).scale.x});
+            }
+        }
+
+        visibleObjects.clear();
+        cullingBatch.cull(frameInfo.camera.getFrustum(), visibleObjects);
 
-            auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
+        // blended, so back to front. lights at the same distance no longer replace each other
+        drawPackets.clear();
+        for (auto id : visibleObjects) {
+            auto offset = frameInfo.camera.getPosition() - bvh.getBounds(id).center();
             float disSquared = glm::dot(offset, offset);
-            sorted[disSquared] = obj.getId();
+            drawPackets.push_back({BananDrawPacket::makeKey(0, 0, 0, disSquared, 0, true), id});
+        }
+        sortDrawPackets(drawPackets, drawPacketScratch);
+
+        if (drawPackets.empty()) {
+            return;
+        }
+
+        assert(drawPackets.size() <= maxLights && "More visible point lights than the light buffer was sized for");
+        auto *lightIds = static_cast<uint32_t *>(lightBuffers[frameInfo.frameIndex]->getMappedMemory());
+        for (size_t i = 0; i < drawPackets.size(); i++) {
+            lightIds[i] = drawPackets[i].index;
         }
 
         bananPipeline->bind(frameInfo.commandBuffer);
@@ -74,22 +99,16 @@ namespace Banan{
         std::vector<VkDescriptorSet> sets{frameInfo.globalDescriptorSet};
         vkCmdBindDescriptorSets(frameInfo.commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pipelineLayout,0,sets.size(),sets.data(),0,nullptr);
 
-        for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
-            vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(BananGameObject::id_t), &it->second);
-            vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
-        }
-
-        vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
+        // one instance per light, instances are blended in order so the sort still holds
+        vkCmdDraw(frameInfo.commandBuffer, 6, static_cast<uint32_t>(drawPackets.size()), 0, 0);
     }
 
     void PointLightSystem::update(BananFrameInfo &frameInfo) {
-        for (auto &kv : frameInfo.gameObjects) {
-            auto &obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
-
-            auto rotateLight = glm::rotate(glm::mat4(1.f), frameInfo.frameTime, {0.f, -1.f, 0.f});
-            obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
-        }
+        auto rotateLight = glm::rotate(glm::mat4(1.f), frameInfo.frameTime, {0.f, -1.f, 0.f});
+        frameInfo.gameObjects.each<PointLightComponent, TransformComponent>([&](BananGameObject::id_t id, PointLightComponent &, TransformComponent &transform) {
+            transform.translation = glm::vec3(rotateLight * glm::vec4(transform.translation, 1.f));
+            frameInfo.gameObjects.markDirty(id);
+        });
     }
 
     void PointLightSystem::reconstructPipeline(VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> layouts) {
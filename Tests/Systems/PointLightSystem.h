@@ -4,6 +4,8 @@
 #pragma once
 
 #include <banan_camera.h>
+#include <banan_culling_batch.h>
+#include <banan_draw_packet.h>
 #include <banan_pipeline.h>
 #include <banan_device.h>
 #include <banan_game_object.h>
@@ -18,9 +20,12 @@ namespace Banan{
             PointLightSystem(const PointLightSystem &) = delete;
             PointLightSystem &operator=(const PointLightSystem &) = delete;
 
-            PointLightSystem(BananDevice &device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> layouts);
+            PointLightSystem(BananDevice &device, VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> layouts, uint32_t maxLights);
             ~PointLightSystem();
 
+            // object id per instance of the light draw in back to front order, goes into binding 9 of the global set
+            VkDescriptorBufferInfo getLightBufferInfo(int frameIndex);
+
             void update(BananFrameInfo &frameInfo);
             void render(BananFrameInfo &frameInfo);
 
@@ -33,5 +38,14 @@ namespace Banan{
             BananDevice &bananDevice;
             std::unique_ptr<BananPipeline> bananPipeline;
             VkPipelineLayout pipelineLayout;
+
+            BananCullingBatch cullingBatch;
+            std::vector<BananGameObject::id_t> visibleObjects;
+
+            std::vector<BananDrawPacket> drawPackets;
+            std::vector<BananDrawPacket> drawPacketScratch;
+
+            uint32_t maxLights;
+            std::vector<std::unique_ptr<BananBuffer>> lightBuffers{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
     };
 }
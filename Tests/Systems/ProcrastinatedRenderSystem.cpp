@@ -4,10 +4,42 @@
 
 #include "ProcrastinatedRenderSystem.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <stdexcept>
 
 namespace Banan {
-    ProcrastinatedRenderSystem::ProcrastinatedRenderSystem(BananDevice &device, VkRenderPass mainRenderPass, std::vector<VkDescriptorSetLayout> layouts, std::vector<VkDescriptorSetLayout> procrastinatedLayouts) : bananDevice{device} {
+    ProcrastinatedRenderSystem::ProcrastinatedRenderSystem(BananDevice &device, BananRenderer &renderer, BananJobSystem &jobSystem, VkRenderPass mainRenderPass, std::vector<VkDescriptorSetLayout> layouts, std::vector<VkDescriptorSetLayout> procrastinatedLayouts, uint32_t maxInstances) : bananDevice{device}, bananRenderer{renderer}, jobSystem{jobSystem}, maxInstances{maxInstances} {
+        // the early and the late draws each get a run of the instance buffer and a command per model
+        for (int i = 0; i < BananSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+            instanceBuffers[i] = std::make_unique<BananBuffer>(bananDevice, sizeof(uint32_t), maxInstances * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            objectModelBuffers[i] = std::make_unique<BananBuffer>(bananDevice, sizeof(uint32_t), maxInstances, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            objectModelBuffers[i]->map();
+
+            modelBuffers[i] = std::make_unique<BananBuffer>(bananDevice, sizeof(ModelRecord), maxInstances, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            modelBuffers[i]->map();
+
+            drawBuffers[i] = std::make_unique<BananBuffer>(bananDevice, sizeof(BananModel::IndirectCommand), maxInstances * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            drawBuffers[i]->map();
+        }
+
+        // nothing was visible before the first frame, so that one draws everything in the late pass
+        visibilityBuffer = std::make_unique<BananBuffer>(bananDevice, sizeof(uint32_t), maxInstances, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        visibilityBuffer->map();
+        std::memset(visibilityBuffer->getMappedMemory(), 0, visibilityBuffer->getBufferSize());
+        visibilityBuffer->unmap();
+
+        for (uint32_t pass = 0; pass < GBUFFER_PASS_COUNT; pass++) {
+            gBufferRecorders[pass] = std::make_unique<BananCommandRecorder>(bananDevice, BananSwapChain::MAX_FRAMES_IN_FLIGHT, jobSystem.getWorkerCount() + 1);
+            recordedGBuffers[pass].resize(BananSwapChain::MAX_FRAMES_IN_FLIGHT);
+        }
+
+        // the cull pass only reads the global set
+        createCullPipelineLayout(layouts.front());
+        createCullPipeline();
+
         createGBufferPipelineLayout(layouts);
         createGBufferPipeline(mainRenderPass);
 
@@ -16,27 +48,304 @@ namespace Banan {
     }
 
     ProcrastinatedRenderSystem::~ProcrastinatedRenderSystem() {
+        vkDestroyPipelineLayout(bananDevice.device(), cullPipelineLayout, nullptr);
         vkDestroyPipelineLayout(bananDevice.device(), GBufferPipelineLayout, nullptr);
         vkDestroyPipelineLayout(bananDevice.device(), mainRenderTargetPipelineLayout, nullptr);
     }
 
+    void ProcrastinatedRenderSystem::cull(BananFrameInfo &frameInfo) {
+        uint32_t objectCount = frameInfo.gameObjects.size();
+        assert(objectCount <= maxInstances && "More game objects than the cull buffers were sized for");
+
+        // the draw list only depends on the objects, the camera and the pre-pass switch. while none of them changed, an idle
+        // frame skips the coarse cull, the sort and the model maps and at most copies the last list into its buffers
+        CullInputs inputs{frameInfo.gameObjects.getDrawChangeCount(), objectCount, frameInfo.camera.getView(), frameInfo.camera.getProjection(), depthPrepass};
+        if (drawListVersion == 0 || inputs != culledInputs) {
+            buildDrawList(frameInfo);
+            culledInputs = inputs;
+            drawListVersion++;
+        }
+
+        writeDrawBuffers(frameInfo.frameIndex, objectCount);
+
+        if (drawModels.empty()) {
+            return;
+        }
+
+        dispatchCull(frameInfo, 0);
+    }
+
+    void ProcrastinatedRenderSystem::buildDrawList(BananFrameInfo &frameInfo) {
+        auto &models = frameInfo.gameObjects.pool<ModelComponent>();
+        auto &parallaxes = frameInfo.gameObjects.pool<ParallaxComponent>();
+
+        drawModels.clear();
+        modelIndices[0].clear();
+        modelIndices[1].clear();
+        modelPrepassed.clear();
+        prepassModelCount = 0;
+        modelInstanceCounts.clear();
+        modelDepths.clear();
+        modelRecords.clear();
+        drawCommands.clear();
+        instanceCount = 0;
+
+        // a coarse pass over the bvh boxes first, models with nothing on screen don't get a draw at all and the shader only
+        // refines what's left with the exact matrices
+        auto &bvh = frameInfo.gameObjects.getBvh();
+        cullingBatch.clear();
+        for (auto id : models.ids()) {
+            if (bvh.contains(id)) {
+                cullingBatch.push(id, bvh.getBounds(id));
+            }
+        }
+
+        visibleObjects.clear();
+        cullingBatch.cull(frameInfo.camera.getFrustum(), visibleObjects);
+
+        glm::vec3 cameraPosition = frameInfo.camera.getPosition();
+        visiblePrepassed.assign(visibleObjects.size(), 0);
+        for (size_t v = 0; v < visibleObjects.size(); v++) {
+            auto id = visibleObjects[v];
+            const auto &model = models.get(id).model;
+            if (model == nullptr) continue;
+
+            bool prepassed = depthPrepass && parallaxes.has(id) && wantsDepthPrepass(parallaxes.get(id), bvh.getBounds(id), cameraPosition);
+            visiblePrepassed[v] = prepassed;
+
+            auto [it, inserted] = modelIndices[prepassed].try_emplace(model.get(), static_cast<uint32_t>(drawModels.size()));
+            if (inserted) {
+                drawModels.push_back(model);
+                modelPrepassed.push_back(prepassed);
+                modelInstanceCounts.push_back(0);
+                modelDepths.push_back(std::numeric_limits<float>::max());
+                prepassModelCount += prepassed;
+            }
+
+            modelInstanceCounts[it->second]++;
+            modelDepths[it->second] = std::min(modelDepths[it->second], bvh.getBounds(id).distanceSquared(cameraPosition));
+        }
+
+        visibleSlots.assign(visibleObjects.size(), NO_MODEL);
+        if (drawModels.empty()) {
+            return;
+        }
+
+        // pre-passed models first so their depth is down before anything else is shaded, then roughly front to back by each
+        // model's nearest instance, so what's drawn first rejects the parallax shading behind it. the materials are bindless,
+        // so only the pipeline, depth and mesh tell draws apart
+        drawPackets.clear();
+        for (uint32_t i = 0; i < drawModels.size(); i++) {
+            drawPackets.push_back({BananDrawPacket::makeKey(0, modelPrepassed[i] ? 0 : 1, 0, modelDepths[i], i), i});
+        }
+        sortDrawPackets(drawPackets, drawPacketScratch);
+
+        sortedModels.clear();
+        sortedInstanceCounts.clear();
+        sortedPrepassed.clear();
+        for (const auto &packet : drawPackets) {
+            modelIndices[modelPrepassed[packet.index]][drawModels[packet.index].get()] = static_cast<uint32_t>(sortedModels.size());
+            sortedModels.push_back(drawModels[packet.index]);
+            sortedInstanceCounts.push_back(modelInstanceCounts[packet.index]);
+            sortedPrepassed.push_back(modelPrepassed[packet.index]);
+        }
+        drawModels.swap(sortedModels);
+        modelInstanceCounts.swap(sortedInstanceCounts);
+        modelPrepassed.swap(sortedPrepassed);
+
+        // every visible object gets its slot's index so the shader knows which draw it counts into
+        for (size_t v = 0; v < visibleObjects.size(); v++) {
+            BananModel *model = models.get(visibleObjects[v]).model.get();
+            if (model == nullptr) continue;
+
+            visibleSlots[v] = modelIndices[visiblePrepassed[v]][model];
+        }
+
+        // each model gets a run of the instance buffer big enough for all of its objects in both passes, the shader fills
+        // them from the front. the late runs sit behind all of the early ones
+        for (size_t i = 0; i < drawModels.size(); i++) {
+            const BananAABB &bounds = drawModels[i]->getBounds();
+            modelRecords.push_back({glm::vec4{bounds.min, 0.f}, glm::vec4{bounds.max, 0.f}, instanceCount, {}});
+            instanceCount += modelInstanceCounts[i];
+        }
+
+        drawCommands.resize(drawModels.size() * 2);
+        for (size_t i = 0; i < drawModels.size(); i++) {
+            drawCommands[i] = drawModels[i]->indirectCommand(modelRecords[i].instanceOffset);
+            drawCommands[drawModels.size() + i] = drawModels[i]->indirectCommand(instanceCount + modelRecords[i].instanceOffset);
+        }
+    }
+
+    void ProcrastinatedRenderSystem::writeDrawBuffers(int frameIndex, uint32_t objectCount) {
+        // the shader counts instances into the commands, so they start from zero again every frame
+        auto *commands = static_cast<BananModel::IndirectCommand *>(drawBuffers[frameIndex]->getMappedMemory());
+        std::copy(drawCommands.begin(), drawCommands.end(), commands);
+
+        if (writtenDrawLists[frameIndex] == drawListVersion) {
+            return;
+        }
+        writtenDrawLists[frameIndex] = drawListVersion;
+
+        auto *objectModels = static_cast<uint32_t *>(objectModelBuffers[frameIndex]->getMappedMemory());
+        std::fill_n(objectModels, objectCount, NO_MODEL);
+        for (size_t v = 0; v < visibleObjects.size(); v++) {
+            if (visibleSlots[v] != NO_MODEL) {
+                objectModels[visibleObjects[v]] = visibleSlots[v];
+            }
+        }
+
+        auto *records = static_cast<ModelRecord *>(modelBuffers[frameIndex]->getMappedMemory());
+        std::copy(modelRecords.begin(), modelRecords.end(), records);
+    }
+
+    bool ProcrastinatedRenderSystem::wantsDepthPrepass(const ParallaxComponent &parallax, const BananAABB &bounds, const glm::vec3 &cameraPosition) {
+        // height map taps per fragment in gbuffer.frag. occlusion mapping marches numLayers steps and then refines twice with
+        // up to 16 more each. the pre-pass only pays for them on the rim of the texture, where the parallax can cut it off
+        float taps;
+        if (parallax.parallaxmode == 1) {
+            taps = 1.f;
+        } else if (parallax.parallaxmode == 2) {
+            taps = parallax.numLayers + 2.f * 16.f + 2.f;
+        } else {
+            return false;
+        }
+
+        // squared box radius over squared distance, a rough stand in for the share of the view it covers
+        float radiusSquared = glm::dot(bounds.extent(), bounds.extent());
+        float distanceSquared = bounds.distanceSquared(cameraPosition);
+        float coverage = distanceSquared <= radiusSquared ? 1.f : radiusSquared / distanceSquared;
+
+        return taps * coverage >= DEPTH_PREPASS_MIN_COST;
+    }
+
+    void ProcrastinatedRenderSystem::cullOccluded(BananFrameInfo &frameInfo) {
+        // runs even without any draws, objects that left the view still need their visibility cleared
+        dispatchCull(frameInfo, 1);
+    }
+
+    void ProcrastinatedRenderSystem::dispatchCull(BananFrameInfo &frameInfo, uint32_t phase) {
+        uint32_t objectCount = frameInfo.gameObjects.size();
+
+        CullPushConstants push{};
+        const BananFrustum &frustum = frameInfo.camera.getFrustum();
+        std::copy(std::begin(frustum.planes), std::end(frustum.planes), std::begin(push.planes));
+        push.objectCount = objectCount;
+        push.phase = phase;
+        push.modelCount = static_cast<uint32_t>(drawModels.size());
+        push.instanceBase = instanceCount;
+
+        cullPipeline->bind(frameInfo.commandBuffer);
+        vkCmdBindDescriptorSets(frameInfo.commandBuffer,VK_PIPELINE_BIND_POINT_COMPUTE,cullPipelineLayout,0,1,&frameInfo.globalDescriptorSet,0,nullptr);
+        vkCmdPushConstants(frameInfo.commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &push);
+        vkCmdDispatch(frameInfo.commandBuffer, (objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        // the draws read the counts as indirect parameters and gbuffer.vert reads the ids
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(frameInfo.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void ProcrastinatedRenderSystem::renderEarlyGBuffer(BananFrameInfo &frameInfo) {
+        drawGBuffer(frameInfo, EARLY_PASS);
+
+        // the early pass only fills the g-buffer, its composite and forward subpasses stay empty
+        vkCmdNextSubpass(frameInfo.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdNextSubpass(frameInfo.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    }
+
     void ProcrastinatedRenderSystem::calculateGBuffer(BananFrameInfo &frameInfo) {
-        GBufferPipeline->bind(frameInfo.commandBuffer);
+        drawGBuffer(frameInfo, LATE_PASS);
+
+        vkCmdNextSubpass(frameInfo.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    }
+
+    void ProcrastinatedRenderSystem::drawGBuffer(BananFrameInfo &frameInfo, GBufferPass pass) {
         std::vector<VkDescriptorSet> sets = {frameInfo.globalDescriptorSet, frameInfo.textureDescriptorSet, frameInfo.normalDescriptorSet, frameInfo.heightDescriptorSet};
+        RecordedGBuffer &recorded = recordedGBuffers[pass][frameInfo.frameIndex];
+
+        // the texture sets are update after bind, so slots handed out since recording don't invalidate anything either
+        if (recorded.valid && recorded.models == drawModels && recorded.prepassModelCount == prepassModelCount && recorded.sets == sets) {
+            if (!recorded.commandBuffers.empty()) {
+                vkCmdExecuteCommands(frameInfo.commandBuffer, static_cast<uint32_t>(recorded.commandBuffers.size()), recorded.commandBuffers.data());
+            }
+            return;
+        }
+
+        // this frame's fence has signalled, nothing can still be executing the old buffers
+        BananCommandRecorder &recorder = *gBufferRecorders[pass];
+        recorder.reset(frameInfo.frameIndex);
+
+        VkBuffer drawBuffer = drawBuffers[frameInfo.frameIndex]->getBuffer();
+        size_t firstCommand = pass == EARLY_PASS ? 0 : drawModels.size();
+
+        // the pre-passed slots are drawn twice, depth only and then with the equal depth test, ahead of everything else.
+        // command buffers execute in order, so the depth draws are done before any range tests against them
+        size_t drawCount = prepassModelCount + drawModels.size();
 
-        vkCmdBindDescriptorSets(frameInfo.commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,GBufferPipelineLayout,0,sets.size(),sets.data(),0,nullptr);
+        // at most one range per thread that can record, each one goes into its own secondary command buffer
+        size_t threadCount = jobSystem.getWorkerCount() + 1;
+        size_t grainSize = std::max(MIN_DRAWS_PER_RANGE, (drawCount + threadCount - 1) / threadCount);
+        recorded.commandBuffers.assign((drawCount + grainSize - 1) / grainSize, VK_NULL_HANDLE);
 
-        for (auto &kv : frameInfo.gameObjects) {
-            auto &obj = kv.second;
-            if (obj.model == nullptr) continue;
+        jobSystem.parallelFor(drawCount, grainSize, [&](size_t begin, size_t end) {
+            VkCommandBuffer commandBuffer = bananRenderer.beginSecondaryCommandBuffer(recorder, jobSystem.getThreadIndex(), 0);
 
-            vkCmdPushConstants(frameInfo.commandBuffer, GBufferPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(BananGameObject::id_t), &kv.first);
+            // every pipeline shares the g-buffer layout, so the sets stay bound across the switches
+            BananPipeline *boundPipeline = nullptr;
 
-            obj.model->bindAll(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+            // one draw per model no matter how many objects use it, the shader may still have culled all of a model's instances
+            for (size_t i = begin; i < end; i++) {
+                bool depthOnly = i < prepassModelCount;
+                size_t slot = depthOnly ? i : i - prepassModelCount;
+
+                BananPipeline *pipeline = depthOnly ? depthPrepassPipeline.get() : slot < prepassModelCount ? prepassedGBufferPipeline.get() : GBufferPipeline.get();
+                if (pipeline != boundPipeline) {
+                    pipeline->bind(commandBuffer);
+                    if (boundPipeline == nullptr) {
+                        vkCmdBindDescriptorSets(commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,GBufferPipelineLayout,0,sets.size(),sets.data(),0,nullptr);
+                    }
+                    boundPipeline = pipeline;
+                }
+
+                drawModels[slot]->bindAll(commandBuffer);
+                drawModels[slot]->drawIndirect(commandBuffer, drawBuffer, (firstCommand + slot) * sizeof(BananModel::IndirectCommand));
+            }
+
+            bananRenderer.endSecondaryCommandBuffer(commandBuffer);
+            recorded.commandBuffers[begin / grainSize] = commandBuffer;
+        });
+
+        recorded.models = drawModels;
+        recorded.prepassModelCount = prepassModelCount;
+        recorded.sets = sets;
+        recorded.valid = true;
+
+        if (!recorded.commandBuffers.empty()) {
+            vkCmdExecuteCommands(frameInfo.commandBuffer, static_cast<uint32_t>(recorded.commandBuffers.size()), recorded.commandBuffers.data());
         }
+    }
 
-        vkCmdNextSubpass(frameInfo.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    VkDescriptorBufferInfo ProcrastinatedRenderSystem::getInstanceBufferInfo(int frameIndex) {
+        return instanceBuffers[frameIndex]->descriptorInfo();
+    }
+
+    VkDescriptorBufferInfo ProcrastinatedRenderSystem::getObjectModelBufferInfo(int frameIndex) {
+        return objectModelBuffers[frameIndex]->descriptorInfo();
+    }
+
+    VkDescriptorBufferInfo ProcrastinatedRenderSystem::getModelBufferInfo(int frameIndex) {
+        return modelBuffers[frameIndex]->descriptorInfo();
+    }
+
+    VkDescriptorBufferInfo ProcrastinatedRenderSystem::getDrawBufferInfo(int frameIndex) {
+        return drawBuffers[frameIndex]->descriptorInfo();
+    }
+
+    VkDescriptorBufferInfo ProcrastinatedRenderSystem::getVisibilityBufferInfo() {
+        return visibilityBuffer->descriptorInfo();
     }
 
     void ProcrastinatedRenderSystem::render(BananFrameInfo &frameInfo) {
@@ -49,6 +358,29 @@ namespace Banan {
         vkCmdNextSubpass(frameInfo.commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
     }
 
+    void ProcrastinatedRenderSystem::createCullPipeline() {
+        PipelineConfigInfo pipelineConfig{};
+        pipelineConfig.pipelineLayout = cullPipelineLayout;
+        cullPipeline = std::make_unique<BananPipeline>(bananDevice, "shaders/cull.comp.spv", pipelineConfig);
+    }
+
+    void ProcrastinatedRenderSystem::createCullPipelineLayout(VkDescriptorSetLayout globalLayout) {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &globalLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(bananDevice.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
     void ProcrastinatedRenderSystem::createMainRenderTargetPipeline(VkRenderPass renderPass) {
         assert(mainRenderTargetPipelineLayout != nullptr && "pipelineLayout must be created before pipeline");
 
@@ -93,30 +425,51 @@ namespace Banan {
 
         GBufferPipeline = std::make_unique<BananPipeline>(bananDevice, "shaders/gbuffer.vert.spv", "shaders/gbuffer.frag.spv", pipelineConfig);
 
+        // the depth is already there, only the fragments that produced it get shaded
+        pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+        pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+        prepassedGBufferPipeline = std::make_unique<BananPipeline>(bananDevice, "shaders/gbuffer.vert.spv", "shaders/gbuffer_prepassed.frag.spv", pipelineConfig);
+
+        delete[] pipelineConfig.colorBlendInfo.pAttachments;
+
+        // writes nothing but depth, the subpass still has both g-buffer attachments
+        pipelineConfig.colorBlendAttachment.colorWriteMask = 0;
+        pipelineConfig.colorBlendInfo.pAttachments = new VkPipelineColorBlendAttachmentState[2] {pipelineConfig.colorBlendAttachment, pipelineConfig.colorBlendAttachment};
+        pipelineConfig.depthStencilInfo.depthWriteEnable = VK_TRUE;
+        pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+        pipelineConfig.attributeDescriptions = BananModel::Vertex::getParallaxAttributeDescriptions();
+        depthPrepassPipeline = std::make_unique<BananPipeline>(bananDevice, "shaders/depth_prepass.vert.spv", "shaders/depth_prepass.frag.spv", pipelineConfig);
+
         delete[] pipelineConfig.colorBlendInfo.pAttachments;
     }
 
     void ProcrastinatedRenderSystem::createGBufferPipelineLayout(std::vector<VkDescriptorSetLayout> layouts) {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(int);
-
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
         pipelineLayoutInfo.pSetLayouts = layouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
         if (vkCreatePipelineLayout(bananDevice.device(), &pipelineLayoutInfo, nullptr, &GBufferPipelineLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
     }
 
     void ProcrastinatedRenderSystem::reconstructPipeline(VkRenderPass mainRenderPass, std::vector<VkDescriptorSetLayout> layouts, std::vector<VkDescriptorSetLayout> procrastinatedLayouts) {
+        // recorded against the old pipeline, render pass and framebuffer, and the global sets were rewritten
+        for (auto &frames : recordedGBuffers) {
+            for (auto &recorded : frames) {
+                recorded = {};
+            }
+        }
+
+        vkDestroyPipelineLayout(bananDevice.device(), cullPipelineLayout, nullptr);
         vkDestroyPipelineLayout(bananDevice.device(), GBufferPipelineLayout, nullptr);
         vkDestroyPipelineLayout(bananDevice.device(), mainRenderTargetPipelineLayout, nullptr);
 
+        createCullPipelineLayout(layouts.front());
+        createCullPipeline();
+
         createGBufferPipelineLayout(layouts);
         createGBufferPipeline(mainRenderPass);
 
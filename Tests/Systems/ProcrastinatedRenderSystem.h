@@ -5,12 +5,19 @@
 #pragma once
 
 #include <banan_camera.h>
+#include <banan_culling_batch.h>
+#include <banan_draw_packet.h>
 #include <banan_pipeline.h>
 #include <banan_device.h>
 #include <banan_game_object.h>
 #include <banan_frame_info.h>
+#include <banan_job_system.h>
+#include <banan_renderer.h>
 
+#include <array>
+#include <limits>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace Banan{
@@ -19,27 +26,165 @@ namespace Banan{
         ProcrastinatedRenderSystem(const ProcrastinatedRenderSystem &) = delete;
         ProcrastinatedRenderSystem &operator=(const ProcrastinatedRenderSystem &) = delete;
 
-        ProcrastinatedRenderSystem(BananDevice &device, VkRenderPass mainRenderPass, std::vector<VkDescriptorSetLayout> layouts, std::vector<VkDescriptorSetLayout> procrastinatedLayouts);
+        ProcrastinatedRenderSystem(BananDevice &device, BananRenderer &renderer, BananJobSystem &jobSystem, VkRenderPass mainRenderPass, std::vector<VkDescriptorSetLayout> layouts, std::vector<VkDescriptorSetLayout> procrastinatedLayouts, uint32_t maxInstances);
         ~ProcrastinatedRenderSystem();
 
+        // must match local_size_x in cull.comp
+        static constexpr uint32_t WORKGROUP_SIZE = 256;
+
+        // instance to object id remap written by cull.comp and read by gbuffer.vert, goes into binding 3 of the global set
+        VkDescriptorBufferInfo getInstanceBufferInfo(int frameIndex);
+        // model index per object id, model bounds and two indirect draws per model, bindings 4 to 6 of the global set
+        VkDescriptorBufferInfo getObjectModelBufferInfo(int frameIndex);
+        VkDescriptorBufferInfo getModelBufferInfo(int frameIndex);
+        VkDescriptorBufferInfo getDrawBufferInfo(int frameIndex);
+        // which objects ended up visible last frame, shared by every frame in flight, binding 7 of the global set
+        VkDescriptorBufferInfo getVisibilityBufferInfo();
+
+        // frustum culls what was visible last frame on the gpu and fills in the instance counts of the early draws, has to be
+        // recorded after the matrices are computed and outside of a render pass. the cpu side draw list is kept until an object
+        // with a model, the camera or the pre-pass switch changes
+        void cull(BananFrameInfo &frameInfo);
+        // tests everything else against the depth pyramid built from the early pass and fills in the late draws
+        void cullOccluded(BananFrameInfo &frameInfo);
+        // both record the g-buffer subpass into secondary command buffers across the job system, the geometry passes have to
+        // be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. while the models drawn don't change, the buffers this
+        // frame index recorded last time are executed again instead
+        void renderEarlyGBuffer(BananFrameInfo &frameInfo);
         void calculateGBuffer(BananFrameInfo &frameInfo);
         void render(BananFrameInfo &frameInfo);
 
         void reconstructPipeline(VkRenderPass mainRenderPass, std::vector<VkDescriptorSetLayout> layouts, std::vector<VkDescriptorSetLayout> procrastinatedLayouts);
 
+        // parallax mapped objects expensive enough to shade get their depth laid down by a pass that only runs the parallax
+        // cut-off first, then the g-buffer pass only shades the fragments whose depth is equal to it. takes effect with the next cull
+        void setDepthPrepass(bool enabled) { depthPrepass = enabled; }
+        bool usesDepthPrepass() const { return depthPrepass; }
+
     private:
+        static constexpr uint32_t NO_MODEL = std::numeric_limits<uint32_t>::max();
+        // below this many draws a range isn't worth a job and a secondary command buffer of its own
+        static constexpr size_t MIN_DRAWS_PER_RANGE = 64;
+        // estimated height map taps per fragment times the fraction of the view the object's box covers, above this the
+        // second vertex pass is cheaper than the parallax shading it saves on overdrawn fragments
+        static constexpr float DEPTH_PREPASS_MIN_COST = 0.5f;
+
+        enum GBufferPass : uint32_t {
+            EARLY_PASS = 0,
+            LATE_PASS = 1,
+            GBUFFER_PASS_COUNT
+        };
+
+        // what went into a frame's g-buffer secondaries, the draw counts and instances live in buffers the cull pass rewrites
+        // every frame so the recorded commands only go stale when the models or sets do
+        struct RecordedGBuffer {
+            std::vector<std::shared_ptr<BananModel>> models; // also keeps the buffers the draws bind alive
+            std::vector<VkDescriptorSet> sets;
+            std::vector<VkCommandBuffer> commandBuffers;
+            uint32_t prepassModelCount = 0;
+            bool valid = false;
+        };
+
+        // everything the draw list is built from
+        struct CullInputs {
+            uint64_t objectChanges = 0;
+            uint32_t objectCount = 0;
+            glm::mat4 view{1.f};
+            glm::mat4 projection{1.f};
+            bool depthPrepass = false;
+
+            bool operator==(const CullInputs &) const = default;
+        };
+
+        struct CullPushConstants {
+            glm::vec4 planes[6];
+            uint32_t objectCount;
+            uint32_t phase;
+            uint32_t modelCount;
+            uint32_t instanceBase;
+        };
+
+        // mirrors ModelRecord in cull.comp (std430)
+        struct ModelRecord {
+            glm::vec4 boundsMin;
+            glm::vec4 boundsMax;
+            uint32_t instanceOffset;
+            uint32_t padding[3];
+        };
+
+        static bool wantsDepthPrepass(const ParallaxComponent &parallax, const BananAABB &bounds, const glm::vec3 &cameraPosition);
+
+        // the coarse cull, the pre-pass choice and the sort, only rerun when the cull inputs change
+        void buildDrawList(BananFrameInfo &frameInfo);
+        // copies the draw list into a frame's buffers, the model map and records only when that frame hasn't got it yet
+        void writeDrawBuffers(int frameIndex, uint32_t objectCount);
+        void dispatchCull(BananFrameInfo &frameInfo, uint32_t phase);
+        void drawGBuffer(BananFrameInfo &frameInfo, GBufferPass pass);
+
+        void createCullPipeline();
+        void createCullPipelineLayout(VkDescriptorSetLayout globalLayout);
+
         void createMainRenderTargetPipeline(VkRenderPass renderPass);
         void createMainRenderTargetPipelineLayout(std::vector<VkDescriptorSetLayout> layouts);
 
+        // also creates the depth pre-pass pipeline and the g-buffer pipeline that tests against it
         void createGBufferPipeline(VkRenderPass renderPass);
         void createGBufferPipelineLayout(std::vector<VkDescriptorSetLayout> layouts);
 
         BananDevice &bananDevice;
+        BananRenderer &bananRenderer;
+        BananJobSystem &jobSystem;
 
         std::unique_ptr<BananPipeline> GBufferPipeline;
+        std::unique_ptr<BananPipeline> depthPrepassPipeline;
+        std::unique_ptr<BananPipeline> prepassedGBufferPipeline;
         VkPipelineLayout GBufferPipelineLayout;
 
         std::unique_ptr<BananPipeline> mainRenderTargetPipeline;
         VkPipelineLayout mainRenderTargetPipelineLayout;
+
+        std::unique_ptr<BananPipeline> cullPipeline;
+        VkPipelineLayout cullPipelineLayout;
+
+        uint32_t maxInstances;
+        bool depthPrepass = true;
+
+        BananCullingBatch cullingBatch;
+        std::vector<BananGameObject::id_t> visibleObjects;
+        std::vector<uint8_t> visiblePrepassed; // parallel to visibleObjects
+        std::vector<uint32_t> visibleSlots; // parallel to visibleObjects, NO_MODEL for objects without a model
+
+        // every model in use this frame in draw order, the index is the model's slot in the model and draw buffers. a model
+        // used by pre-passed and by other objects gets a slot for each, the first prepassModelCount slots are pre-passed
+        std::vector<std::shared_ptr<BananModel>> drawModels;
+        std::array<std::unordered_map<BananModel *, uint32_t>, 2> modelIndices; // [pre-passed]
+        std::vector<uint8_t> modelPrepassed;
+        uint32_t prepassModelCount = 0;
+        std::vector<uint32_t> modelInstanceCounts;
+        // squared camera distance to the nearest visible instance of each model
+        std::vector<float> modelDepths;
+
+        std::vector<BananDrawPacket> drawPackets;
+        std::vector<BananDrawPacket> drawPacketScratch;
+        std::vector<std::shared_ptr<BananModel>> sortedModels;
+        std::vector<uint32_t> sortedInstanceCounts;
+        std::vector<uint8_t> sortedPrepassed;
+        uint32_t instanceCount = 0;
+
+        // the built draw list as it's written into each frame's buffers
+        std::vector<ModelRecord> modelRecords;
+        std::vector<BananModel::IndirectCommand> drawCommands;
+        CullInputs culledInputs;
+        uint64_t drawListVersion = 0;
+        std::array<uint64_t, BananSwapChain::MAX_FRAMES_IN_FLIGHT> writtenDrawLists{}; // draw list version in each frame's buffers
+
+        std::array<std::unique_ptr<BananCommandRecorder>, GBUFFER_PASS_COUNT> gBufferRecorders;
+        std::array<std::vector<RecordedGBuffer>, GBUFFER_PASS_COUNT> recordedGBuffers; // [pass][frame]
+
+        std::vector<std::unique_ptr<BananBuffer>> instanceBuffers{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
+        std::vector<std::unique_ptr<BananBuffer>> objectModelBuffers{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
+        std::vector<std::unique_ptr<BananBuffer>> modelBuffers{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
+        std::vector<std::unique_ptr<BananBuffer>> drawBuffers{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
+        std::unique_ptr<BananBuffer> visibilityBuffer;
     };
 }
@@ -63,15 +63,12 @@ namespace Banan{
 
         vkCmdBindDescriptorSets(frameInfo.commandBuffer,VK_PIPELINE_BIND_POINT_GRAPHICS,pipelineLayout,0,sets.size(),sets.data(),0,nullptr);
 
-        for (auto &kv : frameInfo.gameObjects) {
-            auto &obj = kv.second;
-            if (obj.model == nullptr) continue;
+        frameInfo.gameObjects.each<ModelComponent>([&](BananGameObject::id_t id, ModelComponent &modelComponent) {
+            vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(BananGameObject::id_t), &id);
 
-            vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(BananGameObject::id_t), &kv.first);
-
-            obj.model->bindAll(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
-        }
+            modelComponent.model->bindAll(frameInfo.commandBuffer);
+            modelComponent.model->draw(frameInfo.commandBuffer);
+        });
     }
 
     void SimpleRenderSystem::reconstructPipeline(VkRenderPass renderPass, std::vector<VkDescriptorSetLayout> layouts) {
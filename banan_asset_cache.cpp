@@ -0,0 +1,316 @@
+#include "banan_asset_cache.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+namespace Banan {
+
+    BananAssetCache::BananAssetCache(BananDevice &device) : bananDevice{device} {
+    }
+
+    std::shared_ptr<BananModel> BananAssetCache::loadModel(const std::string &filepath, const ModelImportSettings &settings) {
+        std::string key = modelKey(filepath, settings);
+
+        auto keyIt = modelKeys.find(key);
+        if (keyIt != modelKeys.end()) {
+            auto modelIt = models.find(keyIt->second);
+            if (modelIt != models.end()) {
+                return modelIt->second;
+            }
+        }
+
+        ContentKey contentKey{hashFile(filepath), settings.postProcessFlags};
+        modelKeys[key] = contentKey;
+
+        auto modelIt = models.find(contentKey);
+        if (modelIt != models.end()) {
+            return modelIt->second;
+        }
+
+        BananModel::Builder builder{};
+        builder.loadModel(filepath, settings.postProcessFlags);
+
+        auto model = std::make_shared<BananModel>(bananDevice, builder);
+        models.emplace(contentKey, model);
+        assetPaths.emplace(model.get(), filepath);
+        return model;
+    }
+
+    std::shared_ptr<BananImage> BananAssetCache::loadTexture(const std::string &filepath, const TextureImportSettings &settings) {
+        assert(!settings.atlas && "Atlased textures are only usable with their uv transform, load them with loadTextureRegion");
+        return loadTextureRegion(filepath, settings).page;
+    }
+
+    BananAtlasRegion BananAssetCache::loadTextureRegion(const std::string &filepath, const TextureImportSettings &settings) {
+        std::string key = textureKey(filepath, settings);
+
+        auto keyIt = textureKeys.find(key);
+        if (keyIt != textureKeys.end()) {
+            auto textureIt = textures.find(keyIt->second);
+            if (textureIt != textures.end()) {
+                return textureIt->second;
+            }
+        }
+
+        ContentKey contentKey{hashFile(filepath), textureSettingsKey(settings)};
+        textureKeys[key] = contentKey;
+
+        auto textureIt = textures.find(contentKey);
+        if (textureIt != textures.end()) {
+            return textureIt->second;
+        }
+
+        BananModel::Builder builder{};
+        builder.stagingDevice = &bananDevice;
+        builder.loadImage(filepath, builder.texture, settings.type);
+
+        // packing only pays off with a whole batch of textures at once, which is what preload gets
+        BananAtlasRegion region{uploadTexture(builder.texture, settings)};
+        textures.emplace(contentKey, region);
+        assetPaths.emplace(region.page.get(), filepath);
+        return region;
+    }
+
+    void BananAssetCache::preload(BananJobSystem &jobSystem, const std::vector<std::string> &modelPaths, const std::vector<std::pair<std::string, TextureImportSettings>> &texturePaths) {
+        struct PendingModel {
+            std::string path;
+            std::string key;
+            ContentKey contentKey;
+            BananModel::Builder builder{};
+        };
+
+        struct PendingTexture {
+            std::string path;
+            std::string key;
+            TextureImportSettings settings;
+            ContentKey contentKey;
+            BananModel::Builder builder{};
+        };
+
+        // only paths that aren't cached yet, each at most once
+        std::vector<PendingModel> pendingModels;
+        std::unordered_set<std::string> seen;
+        for (auto &path : modelPaths) {
+            std::string key = modelKey(path, {});
+            auto keyIt = modelKeys.find(key);
+            if ((keyIt != modelKeys.end() && models.contains(keyIt->second)) || seen.contains(key)) {
+                continue;
+            }
+
+            seen.insert(key);
+            pendingModels.push_back({path, key});
+        }
+
+        std::vector<PendingTexture> pendingTextures;
+        seen.clear();
+        for (auto &[path, settings] : texturePaths) {
+            std::string key = textureKey(path, settings);
+            auto keyIt = textureKeys.find(key);
+            if ((keyIt != textureKeys.end() && textures.contains(keyIt->second)) || seen.contains(key)) {
+                continue;
+            }
+
+            seen.insert(key);
+            pendingTextures.push_back({path, key, settings});
+        }
+
+        // the maps aren't touched until every job is done, so jobs only read their own entry. content that turns out to be
+        // cached already is still decoded, which only costs time when the same file sits under two paths
+        size_t total = pendingModels.size() + pendingTextures.size();
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        jobSystem.parallelFor(total, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                try {
+                    if (i < pendingModels.size()) {
+                        auto &pending = pendingModels[i];
+                        pending.contentKey = {hashFile(pending.path), ModelImportSettings{}.postProcessFlags};
+                        pending.builder.loadModel(pending.path);
+                    } else {
+                        auto &pending = pendingTextures[i - pendingModels.size()];
+                        pending.contentKey = {hashFile(pending.path), textureSettingsKey(pending.settings)};
+                        // buffers can be created from any thread, so decoders that can write straight into upload memory do
+                        pending.builder.stagingDevice = &bananDevice;
+                        pending.builder.loadImage(pending.path, pending.builder.texture, pending.settings.type);
+                    }
+                } catch (...) {
+                    // workers can't throw, the first failure is rethrown here once everything has stopped
+                    std::lock_guard<std::mutex> lock{errorMutex};
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        });
+
+        // textures embedded in a model are only freed by the model that uploads them
+        auto releaseModelTextures = [](BananModel::Builder &builder) {
+            builder.texture.release();
+            builder.normals.release();
+            builder.heights.release();
+        };
+
+        if (error) {
+            for (auto &pending : pendingModels) {
+                releaseModelTextures(pending.builder);
+            }
+            for (auto &pending : pendingTextures) {
+                pending.builder.texture.release();
+            }
+            std::rethrow_exception(error);
+        }
+
+        // uploads go through the device's single queue, so they stay on this thread
+        for (auto &pending : pendingModels) {
+            modelKeys[pending.key] = pending.contentKey;
+            if (!models.contains(pending.contentKey)) {
+                auto model = std::make_shared<BananModel>(bananDevice, pending.builder);
+                models.emplace(pending.contentKey, model);
+                assetPaths.emplace(model.get(), pending.path);
+            } else {
+                releaseModelTextures(pending.builder);
+            }
+        }
+
+        // small textures that asked for it share pages, the same content under two paths is only packed once
+        BananTextureAtlas atlas{bananDevice};
+        std::unordered_map<ContentKey, std::pair<uint32_t, std::string>, ContentKeyHasher> atlasEntries; // content key -> entry, first path
+        for (auto &pending : pendingTextures) {
+            textureKeys[pending.key] = pending.contentKey;
+            if (textures.contains(pending.contentKey) || atlasEntries.contains(pending.contentKey)) {
+                pending.builder.texture.release();
+            } else if (pending.settings.atlas && atlas.canPack(pending.builder.texture)) {
+                atlasEntries.emplace(pending.contentKey, std::make_pair(atlas.add(pending.builder.texture), pending.path));
+                pending.builder.texture = {};
+            } else {
+                BananAtlasRegion region{uploadTexture(pending.builder.texture, pending.settings)};
+                textures.emplace(pending.contentKey, region);
+                assetPaths.emplace(region.page.get(), pending.path);
+            }
+        }
+
+        if (atlasEntries.empty()) {
+            return;
+        }
+
+        atlas.build();
+        for (auto &[contentKey, entry] : atlasEntries) {
+            const BananAtlasRegion &region = atlas.getRegion(entry.first);
+            textures.emplace(contentKey, region);
+            regionPaths[region.page.get()].push_back({region.uvTransform, entry.second});
+        }
+    }
+
+    std::string BananAssetCache::getPath(const void *asset) const {
+        auto it = assetPaths.find(asset);
+        return it != assetPaths.end() ? it->second : std::string{};
+    }
+
+    std::string BananAssetCache::getPath(const void *asset, const glm::vec4 &uvTransform) const {
+        if (auto it = regionPaths.find(asset); it != regionPaths.end()) {
+            for (auto &[transform, path] : it->second) {
+                if (transform == uvTransform) {
+                    return path;
+                }
+            }
+            return {};
+        }
+
+        return getPath(asset);
+    }
+
+    std::shared_ptr<BananImage> BananAssetCache::uploadTexture(BananModel::Texture &texture, const TextureImportSettings &settings) {
+        if (!settings.generateMipMaps) {
+            texture.mipLevels = 1;
+        }
+
+        std::shared_ptr<BananImage> image = BananModel::createImageFromTexture(bananDevice, texture);
+        texture.release();
+        return image;
+    }
+
+    void BananAssetCache::purgeUnused() {
+        auto unused = [this](const auto &kv) {
+            if (kv.second.use_count() != 1) {
+                return false;
+            }
+
+            assetPaths.erase(kv.second.get());
+            return true;
+        };
+
+        std::erase_if(models, unused);
+
+        // an atlas page is referenced once by each of its regions in the cache, it's unused when nothing else holds it
+        std::unordered_map<const BananImage *, long> cacheReferences;
+        for (auto &[key, region] : textures) {
+            cacheReferences[region.page.get()]++;
+        }
+
+        std::unordered_set<const BananImage *> unusedPages;
+        for (auto &[key, region] : textures) {
+            if (region.page.use_count() == cacheReferences[region.page.get()]) {
+                unusedPages.insert(region.page.get());
+            }
+        }
+
+        for (const BananImage *page : unusedPages) {
+            assetPaths.erase(page);
+            regionPaths.erase(page);
+        }
+        std::erase_if(textures, [&unusedPages](const auto &kv) { return unusedPages.contains(kv.second.page.get()); });
+
+        std::erase_if(modelKeys, [this](const auto &kv) { return !models.contains(kv.second); });
+        std::erase_if(textureKeys, [this](const auto &kv) { return !textures.contains(kv.second); });
+    }
+
+    BananAssetCache::ContentHash BananAssetCache::hashFile(const std::string &filepath) {
+        std::ifstream file{filepath, std::ios::binary};
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open asset: " + filepath);
+        }
+
+        // FNV-1a and a rotate multiply hash with unrelated constants, both fast enough that hashing is dwarfed by decoding
+        // the same file
+        ContentHash content{0xcbf29ce484222325ull, 0x243f6a8885a308d3ull, 0};
+        std::vector<char> chunk(1 << 16);
+        while (file) {
+            file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            std::streamsize count = file.gcount();
+            for (std::streamsize i = 0; i < count; i++) {
+                auto byte = static_cast<uint8_t>(chunk[i]);
+                content.hash ^= byte;
+                content.hash *= 0x100000001b3ull;
+                content.secondHash = ((content.secondHash << 5 | content.secondHash >> 59) ^ byte) * 0x9e3779b97f4a7c15ull;
+            }
+            content.size += static_cast<uint64_t>(count);
+        }
+
+        return content;
+    }
+
+    std::string BananAssetCache::modelKey(const std::string &filepath, const ModelImportSettings &settings) {
+        return canonicalPath(filepath) + "|" + std::to_string(settings.postProcessFlags);
+    }
+
+    std::string BananAssetCache::textureKey(const std::string &filepath, const TextureImportSettings &settings) {
+        return canonicalPath(filepath) + "|" + std::to_string(textureSettingsKey(settings));
+    }
+
+    uint64_t BananAssetCache::textureSettingsKey(const TextureImportSettings &settings) {
+        return static_cast<uint64_t>(settings.type) << 2 | static_cast<uint64_t>(settings.atlas) << 1 | settings.generateMipMaps;
+    }
+
+    std::string BananAssetCache::canonicalPath(const std::string &filepath) {
+        std::error_code error;
+        auto path = std::filesystem::weakly_canonical(filepath, error);
+        return error ? filepath : path.string();
+    }
+}
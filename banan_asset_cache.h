@@ -0,0 +1,97 @@
+#pragma once
+
+#include "banan_model.h"
+#include "banan_image.h"
+#include "banan_job_system.h"
+#include "banan_texture_atlas.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Banan {
+    struct ModelImportSettings {
+        unsigned int postProcessFlags = BananModel::DEFAULT_POST_PROCESS_FLAGS;
+    };
+
+    struct TextureImportSettings {
+        BananModel::TextureType type = BananModel::TextureType::ALBEDO;
+        bool generateMipMaps = true;
+        // small textures loaded by preload share atlas pages, only for callers that apply the region's uv transform
+        bool atlas = false;
+    };
+
+    class BananAssetCache {
+    public:
+        BananAssetCache(BananDevice &device);
+
+        BananAssetCache(const BananAssetCache &) = delete;
+        BananAssetCache &operator=(const BananAssetCache &) = delete;
+
+        // models loaded through the cache only hold geometry, textures are shared separately through loadTexture
+        std::shared_ptr<BananModel> loadModel(const std::string &filepath, const ModelImportSettings &settings = {});
+        std::shared_ptr<BananImage> loadTexture(const std::string &filepath, const TextureImportSettings &settings = {});
+        // the image and where the texture sits inside it, an identity transform unless preload packed it into an atlas page
+        BananAtlasRegion loadTextureRegion(const std::string &filepath, const TextureImportSettings &settings = {});
+
+        // hashes and decodes everything that isn't cached yet on the job system, then uploads on the calling thread. textures
+        // imported with atlas set are packed together here, a cache miss in loadTextureRegion always gets an image of its
+        // own. the load functions are cache hits for these afterwards
+        void preload(BananJobSystem &jobSystem, const std::vector<std::string> &modelPaths, const std::vector<std::pair<std::string, TextureImportSettings>> &texturePaths);
+
+        // the path an asset was first loaded from, empty for assets that didn't come through the cache
+        std::string getPath(const void *asset) const;
+        // atlas pages hold many textures, the transform picks which one
+        std::string getPath(const void *asset, const glm::vec4 &uvTransform) const;
+
+        // drops every asset that is only referenced by the cache
+        void purgeUnused();
+
+        // two independent hashes of a file's bytes and its size. two files only count as the same content when all three
+        // match, so a collision has to hit both hashes at once on files of the same length
+        struct ContentHash {
+            uint64_t hash = 0;
+            uint64_t secondHash = 0;
+            uint64_t size = 0;
+
+            bool operator==(const ContentHash &) const = default;
+        };
+
+        static ContentHash hashFile(const std::string &filepath);
+
+    private:
+        // content hash + import settings
+        struct ContentKey {
+            ContentHash content;
+            uint64_t settings = 0;
+
+            bool operator==(const ContentKey &) const = default;
+        };
+
+        struct ContentKeyHasher {
+            size_t operator()(const ContentKey &key) const { return static_cast<size_t>(key.content.hash ^ (key.settings * 0x9e3779b97f4a7c15ull)); }
+        };
+
+        static std::string canonicalPath(const std::string &filepath);
+        static std::string modelKey(const std::string &filepath, const ModelImportSettings &settings);
+        static std::string textureKey(const std::string &filepath, const TextureImportSettings &settings);
+        static uint64_t textureSettingsKey(const TextureImportSettings &settings);
+
+        std::shared_ptr<BananImage> uploadTexture(BananModel::Texture &texture, const TextureImportSettings &settings);
+
+        BananDevice &bananDevice;
+
+        // canonical path + import settings -> content key, so a path is only hashed the first time it's seen
+        std::unordered_map<std::string, ContentKey> modelKeys;
+        std::unordered_map<std::string, ContentKey> textureKeys;
+
+        // content -> uploaded asset, so identical files under different paths share one upload
+        std::unordered_map<ContentKey, std::shared_ptr<BananModel>, ContentKeyHasher> models;
+        std::unordered_map<ContentKey, BananAtlasRegion, ContentKeyHasher> textures;
+
+        std::unordered_map<const void *, std::string> assetPaths;
+        std::unordered_map<const void *, std::vector<std::pair<glm::vec4, std::string>>> regionPaths; // atlas page -> entries
+    };
+}
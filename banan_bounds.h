@@ -0,0 +1,127 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace Banan {
+    struct BananAABB {
+        // starts inverted so expanding an empty box by anything gives exactly that thing
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+        bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+        void expand(const glm::vec3 &point) {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        void expand(const BananAABB &other) {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+
+        glm::vec3 center() const { return (min + max) * 0.5f; }
+        glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+        float surfaceArea() const {
+            if (!isValid()) return 0.f;
+            glm::vec3 size = max - min;
+            return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        float distanceSquared(const glm::vec3 &point) const {
+            glm::vec3 offset = glm::max(glm::max(min - point, point - max), glm::vec3{0.f});
+            return glm::dot(offset, offset);
+        }
+
+        // bounds of the transformed box, from the center and the absolute value of the rotated extent (arvo)
+        BananAABB transformed(const glm::mat4 &matrix) const {
+            glm::vec3 worldCenter = glm::vec3(matrix * glm::vec4(center(), 1.f));
+            glm::mat3 absolute{glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])), glm::abs(glm::vec3(matrix[2]))};
+            glm::vec3 worldExtent = absolute * extent();
+            return {worldCenter - worldExtent, worldCenter + worldExtent};
+        }
+
+        bool operator==(const BananAABB &other) const = default;
+    };
+
+    struct BananSphere {
+        glm::vec3 center{0.f};
+        float radius = 0.f;
+
+        bool intersects(const BananAABB &box) const { return box.distanceSquared(center) <= radius * radius; }
+    };
+
+    struct BananRay {
+        glm::vec3 origin{0.f};
+        glm::vec3 direction{0.f, 0.f, 1.f};
+
+        // slab test against a box, inverseDirection is 1 / direction so it only gets computed once per query
+        static bool intersects(const glm::vec3 &origin, const glm::vec3 &inverseDirection, const BananAABB &box, float maxDistance, float &distance) {
+            glm::vec3 t0 = (box.min - origin) * inverseDirection;
+            glm::vec3 t1 = (box.max - origin) * inverseDirection;
+            glm::vec3 tMin = glm::min(t0, t1);
+            glm::vec3 tMax = glm::max(t0, t1);
+
+            float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.f));
+            float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+            distance = enter;
+            return enter <= exit;
+        }
+    };
+
+    // six planes facing inwards, xyz is the normal and w the distance so dot(plane, vec4(p, 1)) >= 0 is inside
+    struct BananFrustum {
+        enum class Containment { OUTSIDE, INTERSECTS, INSIDE };
+
+        glm::vec4 planes[6];
+
+        // gribb and hartmann, the near plane is just the z row since clip space depth runs from 0 to w here
+        static BananFrustum fromMatrix(const glm::mat4 &projectionView) {
+            auto row = [&](int i) { return glm::vec4{projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i]}; };
+
+            BananFrustum frustum{};
+            frustum.planes[0] = row(3) + row(0);
+            frustum.planes[1] = row(3) - row(0);
+            frustum.planes[2] = row(3) + row(1);
+            frustum.planes[3] = row(3) - row(1);
+            frustum.planes[4] = row(2);
+            frustum.planes[5] = row(3) - row(2);
+
+            for (auto &plane : frustum.planes) {
+                plane /= glm::length(glm::vec3(plane));
+            }
+            return frustum;
+        }
+
+        Containment classify(const BananAABB &box) const {
+            glm::vec3 center = box.center();
+            glm::vec3 extent = box.extent();
+
+            Containment result = Containment::INSIDE;
+            for (const auto &plane : planes) {
+                glm::vec3 normal{plane};
+                float distance = glm::dot(normal, center) + plane.w;
+                float radius = glm::dot(glm::abs(normal), extent);
+
+                if (distance < -radius) return Containment::OUTSIDE;
+                if (distance < radius) result = Containment::INTERSECTS;
+            }
+            return result;
+        }
+
+        bool intersects(const BananAABB &box) const { return classify(box) != Containment::OUTSIDE; }
+
+        bool intersects(const BananSphere &sphere) const {
+            for (const auto &plane : planes) {
+                if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) return false;
+            }
+            return true;
+        }
+    };
+}
@@ -5,6 +5,7 @@
 #include "banan_buffer.h"
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -83,6 +84,42 @@ namespace Banan {
         return flush(alignmentSize, index * alignmentSize);
     }
 
+    VkResult BananBuffer::flushIndexRanges(const std::vector<std::pair<uint32_t, uint32_t>> &ranges) {
+        if (ranges.empty()) {
+            return VK_SUCCESS;
+        }
+
+        // flush offsets and sizes have to be multiples of nonCoherentAtomSize
+        VkDeviceSize atomSize = std::max<VkDeviceSize>(bananDevice.physicalDeviceProperties().limits.nonCoherentAtomSize, 1);
+
+        std::vector<VkMappedMemoryRange> mappedRanges;
+        for (auto [first, count] : ranges) {
+            VkDeviceSize begin = first * alignmentSize / atomSize * atomSize;
+            VkDeviceSize end = ((first + count) * alignmentSize + atomSize - 1) / atomSize * atomSize;
+
+            if (!mappedRanges.empty() && begin <= mappedRanges.back().offset + mappedRanges.back().size) {
+                auto &last = mappedRanges.back();
+                last.size = std::max(end, last.offset + last.size) - last.offset;
+                continue;
+            }
+
+            VkMappedMemoryRange mappedRange = {};
+            mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            mappedRange.memory = memory;
+            mappedRange.offset = begin;
+            mappedRange.size = end - begin;
+            mappedRanges.push_back(mappedRange);
+        }
+
+        // rounding up can run past the buffer, the rest of the allocation is only guaranteed to be covered by VK_WHOLE_SIZE
+        auto &last = mappedRanges.back();
+        if (last.offset + last.size >= bufferSize) {
+            last.size = VK_WHOLE_SIZE;
+        }
+
+        return vkFlushMappedMemoryRanges(bananDevice.device(), static_cast<uint32_t>(mappedRanges.size()), mappedRanges.data());
+    }
+
     VkDescriptorBufferInfo BananBuffer::descriptorInfoForIndex(int index) {
         return descriptorInfo(alignmentSize, index * alignmentSize);
     }
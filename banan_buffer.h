@@ -6,6 +6,9 @@
 
 #include "banan_device.h"
 
+#include <utility>
+#include <vector>
+
 namespace Banan {
 
     class BananBuffer {
@@ -26,6 +29,8 @@ namespace Banan {
 
         void writeToIndex(void* data, int index);
         VkResult flushIndex(int index);
+        // flushes sorted [first index, count) ranges with a single call, neighbouring ranges that share an atom are merged
+        VkResult flushIndexRanges(const std::vector<std::pair<uint32_t, uint32_t>> &ranges);
         VkDescriptorBufferInfo descriptorInfoForIndex(int index);
         VkResult invalidateIndex(int index);
 
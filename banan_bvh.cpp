@@ -0,0 +1,372 @@
+#include "banan_bvh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+namespace Banan {
+
+    void BananBVH::insert(id_t id, const BananAABB &bounds) {
+        assert(!contains(id) && "Object is already in the bvh");
+
+        if (id >= slots.size()) {
+            slots.resize(id + 1, INVALID_INDEX);
+        }
+
+        slots[id] = static_cast<uint32_t>(primitives.size());
+        primitives.push_back({id, bounds});
+        needsRebuild = true;
+    }
+
+    void BananBVH::update(id_t id, const BananAABB &bounds) {
+        if (!contains(id)) {
+            insert(id, bounds);
+            return;
+        }
+
+        uint32_t slot = slots[id];
+        primitives[slot].bounds = bounds;
+        if (!needsRebuild) {
+            movedPrimitives.push_back(slot);
+        }
+    }
+
+    void BananBVH::remove(id_t id) {
+        if (!contains(id)) return;
+
+        uint32_t slot = slots[id];
+        primitives[slot] = primitives.back();
+        slots[primitives[slot].id] = slot;
+        primitives.pop_back();
+        slots[id] = INVALID_INDEX;
+        needsRebuild = true;
+    }
+
+    void BananBVH::commit() {
+        if (needsRebuild) {
+            build();
+            return;
+        }
+
+        if (movedPrimitives.empty()) {
+            return;
+        }
+
+        refit();
+        movedPrimitives.clear();
+
+        float rootArea = nodes[0].bounds.surfaceArea();
+        if (rootArea > 0.f && totalCost / rootArea > builtCost * REBUILD_THRESHOLD) {
+            build();
+        }
+    }
+
+    float BananBVH::nodeCost(const Node &node) const {
+        return node.bounds.surfaceArea() * (node.isLeaf() ? static_cast<float>(node.count) * INTERSECTION_COST : TRAVERSAL_COST);
+    }
+
+    void BananBVH::build() {
+        uint32_t count = static_cast<uint32_t>(primitives.size());
+
+        nodes.clear();
+        primitiveOrder.resize(count);
+        std::iota(primitiveOrder.begin(), primitiveOrder.end(), 0);
+        primitiveLeaves.assign(count, INVALID_INDEX);
+        movedPrimitives.clear();
+        needsRebuild = false;
+        totalCost = 0.f;
+        builtCost = 0.f;
+
+        if (count == 0) {
+            return;
+        }
+
+        std::vector<glm::vec3> centroids(count);
+        for (uint32_t i = 0; i < count; i++) {
+            centroids[i] = primitives[i].bounds.center();
+        }
+
+        nodes.reserve(2 * count - 1);
+        nodes.push_back({{}, 0, count, 0, INVALID_INDEX});
+
+        std::vector<uint32_t> pending{0};
+        while (!pending.empty()) {
+            uint32_t nodeIndex = pending.back();
+            pending.pop_back();
+
+            uint32_t first = nodes[nodeIndex].first;
+            uint32_t nodeCount = nodes[nodeIndex].count;
+            auto begin = primitiveOrder.begin() + first;
+            auto end = begin + nodeCount;
+
+            BananAABB bounds{};
+            BananAABB centroidBounds{};
+            for (auto it = begin; it != end; ++it) {
+                bounds.expand(primitives[*it].bounds);
+                centroidBounds.expand(centroids[*it]);
+            }
+            nodes[nodeIndex].bounds = bounds;
+
+            // binned SAH, costs are left unnormalised by the node's area so flat or point sized nodes still compare sanely
+            float leafCost = bounds.surfaceArea() * static_cast<float>(nodeCount) * INTERSECTION_COST;
+            float bestCost = std::numeric_limits<float>::max();
+            int bestAxis = -1;
+            uint32_t bestSplit = 0;
+
+            for (int axis = 0; axis < 3 && nodeCount > 1; axis++) {
+                float low = centroidBounds.min[axis];
+                float span = centroidBounds.max[axis] - low;
+                if (span <= 0.f) continue;
+
+                float binScale = static_cast<float>(BIN_COUNT) / span;
+                BananAABB binBounds[BIN_COUNT]{};
+                uint32_t binCounts[BIN_COUNT]{};
+                for (auto it = begin; it != end; ++it) {
+                    uint32_t bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroids[*it][axis] - low) * binScale));
+                    binBounds[bin].expand(primitives[*it].bounds);
+                    binCounts[bin]++;
+                }
+
+                // right to left sweep first, then the left to right sweep evaluates every split between bins
+                float rightCosts[BIN_COUNT]{};
+                BananAABB accumulated{};
+                uint32_t accumulatedCount = 0;
+                for (uint32_t bin = BIN_COUNT - 1; bin > 0; bin--) {
+                    accumulated.expand(binBounds[bin]);
+                    accumulatedCount += binCounts[bin];
+                    rightCosts[bin - 1] = accumulated.surfaceArea() * static_cast<float>(accumulatedCount);
+                }
+
+                accumulated = {};
+                accumulatedCount = 0;
+                for (uint32_t split = 0; split < BIN_COUNT - 1; split++) {
+                    accumulated.expand(binBounds[split]);
+                    accumulatedCount += binCounts[split];
+                    if (accumulatedCount == 0 || accumulatedCount == nodeCount) continue;
+
+                    float cost = TRAVERSAL_COST * bounds.surfaceArea() + INTERSECTION_COST * (accumulated.surfaceArea() * static_cast<float>(accumulatedCount) + rightCosts[split]);
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = split;
+                    }
+                }
+            }
+
+            bool makeLeaf = nodeCount == 1 || (nodeCount <= MAX_LEAF_SIZE && (bestAxis < 0 || leafCost <= bestCost));
+            if (makeLeaf) {
+                for (auto it = begin; it != end; ++it) {
+                    primitiveLeaves[*it] = nodeIndex;
+                }
+                continue;
+            }
+
+            // halves the range when every centroid sits in the same spot and there are too many for one leaf
+            auto middle = begin + nodeCount / 2;
+            if (bestAxis >= 0) {
+                float low = centroidBounds.min[bestAxis];
+                float binScale = static_cast<float>(BIN_COUNT) / (centroidBounds.max[bestAxis] - low);
+                middle = std::partition(begin, end, [&](uint32_t primitive) {
+                    return std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroids[primitive][bestAxis] - low) * binScale)) <= bestSplit;
+                });
+            }
+
+            uint32_t leftCount = static_cast<uint32_t>(middle - begin);
+            uint32_t left = static_cast<uint32_t>(nodes.size());
+            nodes[nodeIndex].left = left;
+            nodes.push_back({{}, first, leftCount, 0, nodeIndex});
+            nodes.push_back({{}, first + leftCount, nodeCount - leftCount, 0, nodeIndex});
+
+            pending.push_back(left + 1);
+            pending.push_back(left);
+        }
+
+        for (const auto &node : nodes) {
+            totalCost += nodeCost(node);
+        }
+
+        float rootArea = nodes[0].bounds.surfaceArea();
+        builtCost = rootArea > 0.f ? totalCost / rootArea : 0.f;
+    }
+
+    void BananBVH::refit() {
+        // walks up from each moved leaf and stops as soon as a node's bounds come out unchanged
+        for (uint32_t primitive : movedPrimitives) {
+            for (uint32_t nodeIndex = primitiveLeaves[primitive]; nodeIndex != INVALID_INDEX; nodeIndex = nodes[nodeIndex].parent) {
+                Node &node = nodes[nodeIndex];
+
+                BananAABB bounds{};
+                if (node.isLeaf()) {
+                    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                        bounds.expand(primitives[primitiveOrder[i]].bounds);
+                    }
+                } else {
+                    bounds = nodes[node.left].bounds;
+                    bounds.expand(nodes[node.left + 1].bounds);
+                }
+
+                if (bounds == node.bounds) break;
+
+                totalCost -= nodeCost(node);
+                node.bounds = bounds;
+                totalCost += nodeCost(node);
+            }
+        }
+    }
+
+    void BananBVH::appendRange(const Node &node, std::vector<id_t> &results) const {
+        for (uint32_t i = node.first; i < node.first + node.count; i++) {
+            results.push_back(primitives[primitiveOrder[i]].id);
+        }
+    }
+
+    void BananBVH::queryFrustum(const BananFrustum &frustum, std::vector<id_t> &results) const {
+        if (nodes.empty()) return;
+
+        std::vector<uint32_t> stack{0};
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+
+            auto containment = frustum.classify(node.bounds);
+            if (containment == BananFrustum::Containment::OUTSIDE) continue;
+
+            // whole subtree inside, its primitives are one contiguous range so nothing below needs testing
+            if (containment == BananFrustum::Containment::INSIDE) {
+                appendRange(node, results);
+                continue;
+            }
+
+            if (!node.isLeaf()) {
+                stack.push_back(node.left);
+                stack.push_back(node.left + 1);
+                continue;
+            }
+
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                const Primitive &primitive = primitives[primitiveOrder[i]];
+                if (frustum.intersects(primitive.bounds)) {
+                    results.push_back(primitive.id);
+                }
+            }
+        }
+    }
+
+    void BananBVH::querySphere(const BananSphere &sphere, std::vector<id_t> &results) const {
+        if (nodes.empty()) return;
+
+        std::vector<uint32_t> stack{0};
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+
+            if (!sphere.intersects(node.bounds)) continue;
+
+            if (!node.isLeaf()) {
+                stack.push_back(node.left);
+                stack.push_back(node.left + 1);
+                continue;
+            }
+
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                const Primitive &primitive = primitives[primitiveOrder[i]];
+                if (sphere.intersects(primitive.bounds)) {
+                    results.push_back(primitive.id);
+                }
+            }
+        }
+    }
+
+    bool BananBVH::queryRay(const BananRay &ray, float maxDistance, id_t &hitId, float &hitDistance) const {
+        if (nodes.empty()) return false;
+
+        glm::vec3 inverseDirection = 1.f / ray.direction;
+        float closest = maxDistance;
+        bool hit = false;
+
+        std::vector<uint32_t> stack{0};
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+
+            float distance;
+            if (!BananRay::intersects(ray.origin, inverseDirection, node.bounds, closest, distance)) continue;
+
+            if (node.isLeaf()) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    const Primitive &primitive = primitives[primitiveOrder[i]];
+                    if (BananRay::intersects(ray.origin, inverseDirection, primitive.bounds, closest, distance)) {
+                        closest = distance;
+                        hitId = primitive.id;
+                        hit = true;
+                    }
+                }
+                continue;
+            }
+
+            // nearer child goes on top so it can shrink closest before the other one is tested
+            float leftDistance, rightDistance;
+            bool leftHit = BananRay::intersects(ray.origin, inverseDirection, nodes[node.left].bounds, closest, leftDistance);
+            bool rightHit = BananRay::intersects(ray.origin, inverseDirection, nodes[node.left + 1].bounds, closest, rightDistance);
+            if (leftHit && rightHit) {
+                bool leftFirst = leftDistance <= rightDistance;
+                stack.push_back(leftFirst ? node.left + 1 : node.left);
+                stack.push_back(leftFirst ? node.left : node.left + 1);
+            } else if (leftHit) {
+                stack.push_back(node.left);
+            } else if (rightHit) {
+                stack.push_back(node.left + 1);
+            }
+        }
+
+        if (hit) {
+            hitDistance = closest;
+        }
+        return hit;
+    }
+
+    void BananBVH::queryNearest(const glm::vec3 &point, size_t k, std::vector<id_t> &results) const {
+        if (nodes.empty() || k == 0) return;
+
+        // best first over nodes, the max heap holds the k closest objects found so far
+        using Entry = std::pair<float, uint32_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> openNodes;
+        std::priority_queue<Entry> closest;
+        openNodes.emplace(nodes[0].bounds.distanceSquared(point), 0);
+
+        while (!openNodes.empty()) {
+            auto [distance, nodeIndex] = openNodes.top();
+            openNodes.pop();
+
+            if (closest.size() == k && distance >= closest.top().first) break;
+
+            const Node &node = nodes[nodeIndex];
+            if (!node.isLeaf()) {
+                openNodes.emplace(nodes[node.left].bounds.distanceSquared(point), node.left);
+                openNodes.emplace(nodes[node.left + 1].bounds.distanceSquared(point), node.left + 1);
+                continue;
+            }
+
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                uint32_t primitive = primitiveOrder[i];
+                float primitiveDistance = primitives[primitive].bounds.distanceSquared(point);
+                if (closest.size() < k) {
+                    closest.emplace(primitiveDistance, primitive);
+                } else if (primitiveDistance < closest.top().first) {
+                    closest.pop();
+                    closest.emplace(primitiveDistance, primitive);
+                }
+            }
+        }
+
+        size_t offset = results.size();
+        results.resize(offset + closest.size());
+        for (size_t i = results.size(); i > offset; i--) {
+            results[i - 1] = primitives[closest.top().second].id;
+            closest.pop();
+        }
+    }
+}
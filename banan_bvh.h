@@ -0,0 +1,79 @@
+#pragma once
+
+#include "banan_bounds.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Banan {
+    // binary tree over world space boxes keyed by game object id. moving objects only refits the nodes above them, the
+    // tree is rebuilt with binned SAH when objects come or go or when refitting has made it too much worse than a fresh build
+    class BananBVH {
+    public:
+        using id_t = unsigned int;
+
+        void insert(id_t id, const BananAABB &bounds);
+        // inserts the object when it isn't in the tree yet
+        void update(id_t id, const BananAABB &bounds);
+        void remove(id_t id);
+        bool contains(id_t id) const { return id < slots.size() && slots[id] != INVALID_INDEX; }
+
+        // applies everything since the last commit, queries only see committed bounds
+        void commit();
+
+        size_t size() const { return primitives.size(); }
+        const BananAABB &getBounds(id_t id) const { return primitives[slots[id]].bounds; }
+
+        void queryFrustum(const BananFrustum &frustum, std::vector<id_t> &results) const;
+        void querySphere(const BananSphere &sphere, std::vector<id_t> &results) const;
+        // closest object box along the ray, good enough for picking but not a triangle test
+        bool queryRay(const BananRay &ray, float maxDistance, id_t &hitId, float &hitDistance) const;
+        // up to k objects sorted by the distance from point to their box, nearest first
+        void queryNearest(const glm::vec3 &point, size_t k, std::vector<id_t> &results) const;
+
+    private:
+        static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+        static constexpr uint32_t BIN_COUNT = 16;
+        static constexpr uint32_t MAX_LEAF_SIZE = 4;
+        static constexpr float TRAVERSAL_COST = 1.f;
+        static constexpr float INTERSECTION_COST = 1.f;
+        // rebuild once refitting has pushed the estimated traversal cost this far past what the last build produced
+        static constexpr float REBUILD_THRESHOLD = 1.5f;
+
+        struct Primitive {
+            id_t id;
+            BananAABB bounds;
+        };
+
+        // every node covers a contiguous range of primitiveOrder, children of internal nodes sit next to each other at left and left + 1
+        struct Node {
+            BananAABB bounds;
+            uint32_t first;
+            uint32_t count;
+            uint32_t left;
+            uint32_t parent;
+
+            bool isLeaf() const { return left == 0; }
+        };
+
+        void build();
+        void refit();
+        float nodeCost(const Node &node) const;
+        void appendRange(const Node &node, std::vector<id_t> &results) const;
+
+        std::vector<Primitive> primitives;
+        std::vector<uint32_t> slots; // id to primitive index
+
+        std::vector<Node> nodes;
+        std::vector<uint32_t> primitiveOrder;
+        std::vector<uint32_t> primitiveLeaves; // primitive index to the leaf holding it
+
+        std::vector<uint32_t> movedPrimitives;
+        bool needsRebuild = false;
+
+        // sum of surface area weighted costs over all nodes, divided by the root's area this is the expected cost of a query
+        float totalCost = 0.f;
+        float builtCost = 0.f;
+    };
+}
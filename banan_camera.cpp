@@ -24,6 +24,8 @@ namespace Banan {
         inverseProjectionMatrix[3][0] = (left + right) / 2.f;
         inverseProjectionMatrix[3][1] = (bottom + top) / 2.f;
         inverseProjectionMatrix[3][2] = near;
+
+        frustumDirty = true;
     }
 
     void BananCamera::setPerspectiveProjection(float fovy, float aspect, float near, float far) {
@@ -42,6 +44,8 @@ namespace Banan {
         inverseProjectionMatrix[3][2] = 1.f;
         inverseProjectionMatrix[2][3] = (near - far) / (near * far);
         inverseProjectionMatrix[3][3] = 1.f / near;
+
+        frustumDirty = true;
     }
 
     const glm::mat4 &BananCamera::getProjection() const {
@@ -92,6 +96,8 @@ namespace Banan {
         inverseViewMatrix[3][0] = position.x;
         inverseViewMatrix[3][1] = position.y;
         inverseViewMatrix[3][2] = position.z;
+
+        frustumDirty = true;
     }
 
     void BananCamera::setViewTarget(glm::vec3 position, glm::vec3 target, glm::vec3 up) {
@@ -135,9 +141,19 @@ namespace Banan {
         inverseViewMatrix[3][0] = position.x;
         inverseViewMatrix[3][1] = position.y;
         inverseViewMatrix[3][2] = position.z;
+
+        frustumDirty = true;
     }
 
      const glm::vec3 BananCamera::getPosition() const {
         return glm::vec3(inverseViewMatrix[3]);
     }
+
+    const BananFrustum &BananCamera::getFrustum() const {
+        if (frustumDirty) {
+            frustum = BananFrustum::fromMatrix(projectionMatrix * viewMatrix);
+            frustumDirty = false;
+        }
+        return frustum;
+    }
 }
@@ -8,6 +8,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include "banan_bounds.h"
+
 namespace Banan {
     class BananCamera {
         public:
@@ -23,10 +25,15 @@ namespace Banan {
             const glm::mat4& getView() const;
             const glm::mat4& getInverseView() const;
             const glm::vec3 getPosition() const;
+            // world space planes of projection * view, only rebuilt after the projection or view has changed
+            const BananFrustum &getFrustum() const;
         private:
             glm::mat4 projectionMatrix{1.f};
             glm::mat4 inverseProjectionMatrix{1.f};
             glm::mat4 viewMatrix{1.f};
             glm::mat4 inverseViewMatrix{1.f};
+
+            mutable BananFrustum frustum{};
+            mutable bool frustumDirty = true;
     };
 }
@@ -0,0 +1,83 @@
+#include "banan_command_recorder.h"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace Banan {
+
+    BananCommandRecorder::BananCommandRecorder(BananDevice &device, uint32_t frameCount, uint32_t threadCount) : bananDevice{device}, threadCount{threadCount} {
+        QueueFamilyIndices queueFamilyIndices = bananDevice.findPhysicalQueueFamilies();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        pools.resize(frameCount);
+        for (auto &framePools : pools) {
+            framePools.resize(threadCount);
+            for (auto &threadPool : framePools) {
+                if (vkCreateCommandPool(bananDevice.device(), &poolInfo, nullptr, &threadPool.commandPool) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create command pool!");
+                }
+            }
+        }
+    }
+
+    BananCommandRecorder::~BananCommandRecorder() {
+        for (auto &framePools : pools) {
+            for (auto &threadPool : framePools) {
+                vkDestroyCommandPool(bananDevice.device(), threadPool.commandPool, nullptr);
+            }
+        }
+    }
+
+    void BananCommandRecorder::reset(int frameIndex) {
+        for (auto &threadPool : pools[frameIndex]) {
+            if (threadPool.used == 0) continue;
+
+            vkResetCommandPool(bananDevice.device(), threadPool.commandPool, 0);
+            threadPool.used = 0;
+        }
+    }
+
+    VkCommandBuffer BananCommandRecorder::begin(int frameIndex, uint32_t threadIndex, const VkCommandBufferInheritanceInfo &inheritanceInfo) {
+        assert(threadIndex < threadCount && "Thread index out of range for the command recorder");
+        ThreadPool &threadPool = pools[frameIndex][threadIndex];
+
+        // buffers are kept across frames, resetting the pool puts them all back in the initial state
+        if (threadPool.used == threadPool.commandBuffers.size()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = threadPool.commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(bananDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate command buffers");
+            }
+            threadPool.commandBuffers.push_back(commandBuffer);
+        }
+
+        VkCommandBuffer commandBuffer = threadPool.commandBuffers[threadPool.used++];
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        // not one time submit, cached buffers are executed again in later frames
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to start recording command buffer");
+        }
+
+        return commandBuffer;
+    }
+
+    void BananCommandRecorder::end(VkCommandBuffer commandBuffer) {
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("unable to stop command buffer recording");
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "banan_device.h"
+
+#include <vector>
+
+namespace Banan {
+    // secondary command buffers for recording one render pass from many threads. every thread gets its own command pool per
+    // frame in flight, so recording never takes a lock, and a frame's pools are reset whole once its fence has signalled.
+    // buffers stay valid until their frame is reset, so a recorder that isn't reset every frame can replay what it recorded
+    class BananCommandRecorder {
+    public:
+        BananCommandRecorder(BananDevice &device, uint32_t frameCount, uint32_t threadCount);
+        ~BananCommandRecorder();
+
+        BananCommandRecorder(const BananCommandRecorder &) = delete;
+        BananCommandRecorder &operator=(const BananCommandRecorder &) = delete;
+
+        // every buffer handed out for the frame becomes invalid, call once the gpu is done with them
+        void reset(int frameIndex);
+
+        // only the thread owning threadIndex may record with it until the next reset of the frame
+        VkCommandBuffer begin(int frameIndex, uint32_t threadIndex, const VkCommandBufferInheritanceInfo &inheritanceInfo);
+        void end(VkCommandBuffer commandBuffer);
+
+        uint32_t getThreadCount() const { return threadCount; }
+
+    private:
+        struct ThreadPool {
+            VkCommandPool commandPool;
+            std::vector<VkCommandBuffer> commandBuffers;
+            size_t used = 0;
+        };
+
+        BananDevice &bananDevice;
+        uint32_t threadCount;
+
+        std::vector<std::vector<ThreadPool>> pools; // [frame][thread]
+    };
+}
@@ -0,0 +1,91 @@
+#include "banan_culling_batch.h"
+#include "banan_simd.h"
+
+namespace Banan {
+
+    void BananCullingBatch::clear() {
+        ids.clear();
+        for (auto *field : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius}) {
+            field->clear();
+        }
+    }
+
+    void BananCullingBatch::reserve(size_t count) {
+        ids.reserve(count);
+        for (auto *field : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius}) {
+            field->reserve(count);
+        }
+    }
+
+    void BananCullingBatch::push(id_t id, const BananSphere &sphere) {
+        ids.push_back(id);
+        centerX.push_back(sphere.center.x);
+        centerY.push_back(sphere.center.y);
+        centerZ.push_back(sphere.center.z);
+        extentX.push_back(0.f);
+        extentY.push_back(0.f);
+        extentZ.push_back(0.f);
+        radius.push_back(sphere.radius);
+    }
+
+    void BananCullingBatch::push(id_t id, const BananAABB &box) {
+        glm::vec3 center = box.center();
+        glm::vec3 extent = box.extent();
+
+        ids.push_back(id);
+        centerX.push_back(center.x);
+        centerY.push_back(center.y);
+        centerZ.push_back(center.z);
+        extentX.push_back(extent.x);
+        extentY.push_back(extent.y);
+        extentZ.push_back(extent.z);
+        radius.push_back(0.f);
+    }
+
+    void BananCullingBatch::cull(const BananFrustum &frustum, std::vector<id_t> &visible) const {
+        size_t count = size();
+        size_t i = 0;
+        for (; i + Simd::NativeFloat::WIDTH <= count; i += Simd::NativeFloat::WIDTH) {
+            uint32_t outside = cullLanes<Simd::NativeFloat>(i, frustum);
+            for (size_t lane = 0; lane < Simd::NativeFloat::WIDTH; lane++) {
+                if ((outside & (1u << lane)) == 0) {
+                    visible.push_back(ids[i + lane]);
+                }
+            }
+        }
+
+        for (; i < count; i++) {
+            if (cullLanes<Simd::ScalarFloat>(i, frustum) == 0) {
+                visible.push_back(ids[i]);
+            }
+        }
+    }
+
+    // same test as BananFrustum::classify, an object is outside once its center is further behind any plane than the
+    // box's projected extent plus the sphere's radius
+    template<typename F>
+    uint32_t BananCullingBatch::cullLanes(size_t first, const BananFrustum &frustum) const {
+        F cx = Simd::load(F{}, &centerX[first]);
+        F cy = Simd::load(F{}, &centerY[first]);
+        F cz = Simd::load(F{}, &centerZ[first]);
+        F ex = Simd::load(F{}, &extentX[first]);
+        F ey = Simd::load(F{}, &extentY[first]);
+        F ez = Simd::load(F{}, &extentZ[first]);
+        F r = Simd::load(F{}, &radius[first]);
+        F zero = Simd::broadcast(F{}, 0.f);
+
+        auto outside = Simd::lessThan(zero, zero);
+        for (const auto &plane : frustum.planes) {
+            F nx = Simd::broadcast(F{}, plane.x);
+            F ny = Simd::broadcast(F{}, plane.y);
+            F nz = Simd::broadcast(F{}, plane.z);
+
+            F distance = Simd::fmadd(nx, cx, Simd::fmadd(ny, cy, Simd::fmadd(nz, cz, Simd::broadcast(F{}, plane.w))));
+            F reach = Simd::fmadd(Simd::abs(nx), ex, Simd::fmadd(Simd::abs(ny), ey, Simd::fmadd(Simd::abs(nz), ez, r)));
+
+            outside = outside | Simd::lessThan(distance, zero - reach);
+        }
+
+        return Simd::moveMask(outside);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "banan_bounds.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Banan {
+    // structure of arrays copy of object bounds, so the frustum test can load a full vector of objects per field. spheres are
+    // stored as boxes with no extent and boxes as spheres with no radius, which lets both go through the same plane test
+    class BananCullingBatch {
+    public:
+        using id_t = unsigned int;
+
+        void clear();
+        void reserve(size_t count);
+        void push(id_t id, const BananSphere &sphere);
+        void push(id_t id, const BananAABB &box);
+        size_t size() const { return ids.size(); }
+
+        // appends the id of everything at least partly inside the frustum, in the order they were pushed
+        void cull(const BananFrustum &frustum, std::vector<id_t> &visible) const;
+
+    private:
+        // bit i is set when object first + i is outside
+        template<typename F>
+        uint32_t cullLanes(size_t first, const BananFrustum &frustum) const;
+
+        std::vector<id_t> ids;
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;
+        std::vector<float> radius;
+    };
+}
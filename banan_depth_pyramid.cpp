@@ -0,0 +1,125 @@
+#include "banan_depth_pyramid.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Banan {
+
+    static uint32_t previousPowerOfTwo(uint32_t value) {
+        uint32_t result = 1;
+        while (result * 2 <= value) {
+            result *= 2;
+        }
+        return result;
+    }
+
+    BananDepthPyramid::BananDepthPyramid(BananDevice &device, VkExtent2D depthExtent) : bananDevice{device}, depthExtent{depthExtent} {
+        extent = {previousPowerOfTwo(depthExtent.width), previousPowerOfTwo(depthExtent.height)};
+
+        levelCount = 1;
+        while ((std::max(extent.width, extent.height) >> levelCount) > 0) {
+            levelCount++;
+        }
+        levelCount = std::min(levelCount, MAX_LEVELS);
+
+        createImage();
+        createViews();
+
+        // texel fetches don't filter, any sampler will do as long as it doesn't wrap
+        BananSamplerInfo samplerInfo{};
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler = bananDevice.getSampler(samplerInfo);
+
+        counterBuffer = std::make_unique<BananBuffer>(bananDevice, sizeof(uint32_t), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        counterBuffer->map();
+        memset(counterBuffer->getMappedMemory(), 0, sizeof(uint32_t));
+        counterBuffer->unmap();
+    }
+
+    BananDepthPyramid::~BananDepthPyramid() {
+        for (auto view : levelViews) {
+            vkDestroyImageView(bananDevice.device(), view, nullptr);
+        }
+        vkDestroyImageView(bananDevice.device(), imageView, nullptr);
+        vkDestroyImage(bananDevice.device(), image, nullptr);
+        vkFreeMemory(bananDevice.device(), memory, nullptr);
+    }
+
+    void BananDepthPyramid::createImage() {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = {extent.width, extent.height, 1};
+        imageInfo.mipLevels = levelCount;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+        bananDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+        // straight to general, the image is never in any other layout
+        VkCommandBuffer commandBuffer = bananDevice.beginSingleTimeCommands();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1};
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        bananDevice.endSingleTimeCommands(commandBuffer);
+    }
+
+    void BananDepthPyramid::createViews() {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1};
+
+        if (vkCreateImageView(bananDevice.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create depth pyramid image view!");
+        }
+
+        levelViews.resize(levelCount);
+        for (uint32_t level = 0; level < levelCount; level++) {
+            viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+            if (vkCreateImageView(bananDevice.device(), &viewInfo, nullptr, &levelViews[level]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create depth pyramid level view!");
+            }
+        }
+    }
+
+    VkDescriptorImageInfo BananDepthPyramid::descriptorInfo() {
+        return {sampler, imageView, VK_IMAGE_LAYOUT_GENERAL};
+    }
+
+    std::vector<VkDescriptorImageInfo> BananDepthPyramid::levelDescriptorInfos() {
+        std::vector<VkDescriptorImageInfo> infos(MAX_LEVELS);
+        for (uint32_t level = 0; level < MAX_LEVELS; level++) {
+            infos[level] = {VK_NULL_HANDLE, levelViews[std::min(level, levelCount - 1)], VK_IMAGE_LAYOUT_GENERAL};
+        }
+        return infos;
+    }
+
+    VkDescriptorBufferInfo BananDepthPyramid::counterDescriptorInfo() {
+        return counterBuffer->descriptorInfo();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "banan_buffer.h"
+
+#include <memory>
+#include <vector>
+
+namespace Banan {
+    // max depth mip chain over the depth attachment for occlusion tests. level 0 is the depth extent rounded down to powers
+    // of two, so every texel of a level covers exactly four of the level below. the image stays in the general layout,
+    // depth_pyramid.comp writes it through one storage view per level and the culling shader reads the whole chain
+    class BananDepthPyramid {
+    public:
+        // must match the size of the levels array in depth_pyramid.comp
+        static constexpr uint32_t MAX_LEVELS = 16;
+
+        BananDepthPyramid(BananDevice &device, VkExtent2D depthExtent);
+        ~BananDepthPyramid();
+
+        BananDepthPyramid(const BananDepthPyramid &) = delete;
+        BananDepthPyramid &operator=(const BananDepthPyramid &) = delete;
+
+        VkDescriptorImageInfo descriptorInfo();
+        // MAX_LEVELS entries, the ones past getLevelCount() repeat the last level so the whole array is always written
+        std::vector<VkDescriptorImageInfo> levelDescriptorInfos();
+        // the count of finished workgroups depth_pyramid.comp uses to find the one that reduces the last levels
+        VkDescriptorBufferInfo counterDescriptorInfo();
+
+        VkImage getImage() const { return image; }
+        VkExtent2D getExtent() const { return extent; }
+        VkExtent2D getDepthExtent() const { return depthExtent; }
+        uint32_t getLevelCount() const { return levelCount; }
+
+    private:
+        void createImage();
+        void createViews();
+
+        BananDevice &bananDevice;
+        VkExtent2D depthExtent;
+        VkExtent2D extent;
+        uint32_t levelCount;
+
+        VkImage image;
+        VkDeviceMemory memory;
+        VkImageView imageView;
+        std::vector<VkImageView> levelViews;
+        VkSampler sampler;
+
+        std::unique_ptr<BananBuffer> counterBuffer;
+    };
+}
@@ -4,6 +4,7 @@
 
 #include "banan_device.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -32,8 +33,10 @@ namespace Banan {
         }
     }
 
+    static std::atomic<uint64_t> nextDeviceId{1};
+
 // class member functions
-    BananDevice::BananDevice(BananWindow &window) : window{window} {
+    BananDevice::BananDevice(BananWindow &window) : window{window}, deviceId{nextDeviceId++} {
         createInstance();
         setupDebugMessenger();
         createSurface();
@@ -43,6 +46,14 @@ namespace Banan {
     }
 
     BananDevice::~BananDevice() {
+        for (auto &kv : samplerCache) {
+            vkDestroySampler(device_, kv.second, nullptr);
+        }
+
+        for (auto &kv : threadPools) {
+            vkDestroyCommandPool(device_, kv.second->commandPool, nullptr);
+        }
+
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -140,12 +151,17 @@ namespace Banan {
         indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
         indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
         indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+        // the bindless texture indices come from per instance object data, so they can differ inside one draw
+        indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
         indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
         indexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
         indexingFeatures.descriptorBindingUniformBufferUpdateAfterBind = VK_TRUE;
 
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
+        deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+        deviceFeatures.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -215,7 +231,7 @@ namespace Banan {
 
         vkGetPhysicalDeviceFeatures2(device, &device_features2);
 
-        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy && indexing_features.descriptorBindingPartiallyBound && indexing_features.runtimeDescriptorArray;
+        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy && supportedFeatures.fragmentStoresAndAtomics && supportedFeatures.drawIndirectFirstInstance && supportedFeatures.shaderStorageImageArrayDynamicIndexing && indexing_features.descriptorBindingPartiallyBound && indexing_features.runtimeDescriptorArray && indexing_features.shaderSampledImageArrayNonUniformIndexing;
     }
 
     void BananDevice::populateDebugMessengerCreateInfo(
@@ -433,15 +449,68 @@ namespace Banan {
         vkBindBufferMemory(device_, buffer, bufferMemory, 0);
     }
 
+    VkResult BananDevice::queueSubmit(uint32_t submitCount, const VkSubmitInfo *submits, VkFence fence) {
+        std::lock_guard<std::mutex> lock{queueMutex};
+        return vkQueueSubmit(graphicsQueue_, submitCount, submits, fence);
+    }
+
+    VkResult BananDevice::queuePresent(const VkPresentInfoKHR &presentInfo) {
+        // the present queue is usually the graphics queue, and even when it isn't one lock is plenty for a present a frame
+        std::lock_guard<std::mutex> lock{queueMutex};
+        return vkQueuePresentKHR(presentQueue_, &presentInfo);
+    }
+
+    void BananDevice::waitIdle() {
+        std::lock_guard<std::mutex> lock{queueMutex};
+        vkDeviceWaitIdle(device_);
+    }
+
+    BananDevice::ThreadCommandPool &BananDevice::threadCommandPool() {
+        thread_local uint64_t cachedDeviceId = 0;
+        thread_local ThreadCommandPool *cachedPool = nullptr;
+        if (cachedDeviceId == deviceId) {
+            return *cachedPool;
+        }
+
+        std::lock_guard<std::mutex> lock{threadPoolMutex};
+        auto &threadPool = threadPools[std::this_thread::get_id()];
+        if (threadPool == nullptr) {
+            threadPool = std::make_unique<ThreadCommandPool>();
+
+            VkCommandPoolCreateInfo poolInfo = {};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.queueFamilyIndex = findPhysicalQueueFamilies().graphicsFamily;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+            if (vkCreateCommandPool(device_, &poolInfo, nullptr, &threadPool->commandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create command pool!");
+            }
+        }
+
+        cachedDeviceId = deviceId;
+        cachedPool = threadPool.get();
+        return *cachedPool;
+    }
+
     VkCommandBuffer BananDevice::beginSingleTimeCommands() {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
-        allocInfo.commandBufferCount = 1;
+        ThreadCommandPool &threadPool = threadCommandPool();
 
+        // finished buffers are recycled, beginning one resets it
         VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+        if (!threadPool.freeCommandBuffers.empty()) {
+            commandBuffer = threadPool.freeCommandBuffers.back();
+            threadPool.freeCommandBuffers.pop_back();
+        } else {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = threadPool.commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate command buffers");
+            }
+        }
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -454,15 +523,61 @@ namespace Banan {
     void BananDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
         vkEndCommandBuffer(commandBuffer);
 
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffer;
+        submitAndWait(commandBuffer);
+
+        threadCommandPool().freeCommandBuffers.push_back(commandBuffer);
+    }
+
+    BananDevice::SubmitBatch::~SubmitBatch() {
+        if (fence != VK_NULL_HANDLE) {
+            vkDestroyFence(device, fence, nullptr);
+        }
+    }
+
+    void BananDevice::submitAndWait(VkCommandBuffer commandBuffer) {
+        std::shared_ptr<SubmitBatch> batch;
+        {
+            std::lock_guard<std::mutex> lock{batchMutex};
+            if (openBatch == nullptr) {
+                openBatch = std::make_shared<SubmitBatch>();
+                openBatch->device = device_;
+            }
+            openBatch->commandBuffers.push_back(commandBuffer);
+            batch = openBatch;
+        }
+
+        // whoever gets the queue first submits everything gathered so far, the others find their batch gone and only wait
+        {
+            std::lock_guard<std::mutex> queueLock{queueMutex};
+
+            std::shared_ptr<SubmitBatch> submitting;
+            {
+                std::lock_guard<std::mutex> lock{batchMutex};
+                if (openBatch == batch) {
+                    submitting = std::move(openBatch);
+                }
+            }
+
+            if (submitting != nullptr) {
+                VkFenceCreateInfo fenceInfo{};
+                fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+                if (vkCreateFence(device_, &fenceInfo, nullptr, &submitting->fence) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create fence!");
+                }
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+                VkSubmitInfo submitInfo{};
+                submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submitInfo.commandBufferCount = static_cast<uint32_t>(submitting->commandBuffers.size());
+                submitInfo.pCommandBuffers = submitting->commandBuffers.data();
+
+                if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, submitting->fence) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to submit single time commands!");
+                }
+            }
+        }
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        // the fence is set before the batch leaves openBatch and the queue lock orders that before we get here
+        vkWaitForFences(device_, 1, &batch->fence, VK_TRUE, UINT64_MAX);
     }
 
     void BananDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
@@ -729,4 +844,59 @@ namespace Banan {
 
         return VK_SAMPLE_COUNT_1_BIT;
     }
+
+    VkSampler BananDevice::getSampler(const BananSamplerInfo &info) {
+        std::lock_guard<std::mutex> lock{samplerMutex};
+
+        auto it = samplerCache.find(info);
+        if (it != samplerCache.end()) {
+            return it->second;
+        }
+
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = info.magFilter;
+        samplerInfo.minFilter = info.minFilter;
+        samplerInfo.mipmapMode = info.mipmapMode;
+        samplerInfo.addressModeU = info.addressModeU;
+        samplerInfo.addressModeV = info.addressModeV;
+        samplerInfo.addressModeW = info.addressModeW;
+
+        samplerInfo.anisotropyEnable = info.maxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+        samplerInfo.maxAnisotropy = std::min(info.maxAnisotropy, properties.limits.maxSamplerAnisotropy);
+
+        samplerInfo.borderColor = info.borderColor;
+        samplerInfo.unnormalizedCoordinates = VK_FALSE;
+        samplerInfo.compareEnable = VK_FALSE;
+        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+
+        samplerInfo.mipLodBias = 0.0f;
+        samplerInfo.minLod = info.minLod;
+        samplerInfo.maxLod = info.maxLod;
+
+        VkSampler sampler;
+        if (vkCreateSampler(device_, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create sampler!");
+        }
+
+        samplerCache.emplace(info, sampler);
+        return sampler;
+    }
+
+    size_t BananSamplerInfoHash::operator()(const BananSamplerInfo &info) const {
+        size_t seed = 0;
+        auto combine = [&seed](size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+
+        combine(std::hash<int>{}(info.magFilter));
+        combine(std::hash<int>{}(info.minFilter));
+        combine(std::hash<int>{}(info.mipmapMode));
+        combine(std::hash<int>{}(info.addressModeU));
+        combine(std::hash<int>{}(info.addressModeV));
+        combine(std::hash<int>{}(info.addressModeW));
+        combine(std::hash<float>{}(info.maxAnisotropy));
+        combine(std::hash<float>{}(info.minLod));
+        combine(std::hash<float>{}(info.maxLod));
+        combine(std::hash<int>{}(info.borderColor));
+        return seed;
+    }
 }
\ No newline at end of file
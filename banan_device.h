@@ -6,7 +6,12 @@
 
 #include "banan_window.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace Banan {
@@ -24,6 +29,25 @@ namespace Banan {
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
+    struct BananSamplerInfo {
+        VkFilter magFilter = VK_FILTER_LINEAR;
+        VkFilter minFilter = VK_FILTER_LINEAR;
+        VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        float maxAnisotropy = 1.0f; // anisotropy is enabled above 1
+        float minLod = 0.0f;
+        float maxLod = VK_LOD_CLAMP_NONE; // the image view already limits the mip range, so most images can share a sampler
+        VkBorderColor borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+        bool operator==(const BananSamplerInfo &other) const = default;
+    };
+
+    struct BananSamplerInfoHash {
+        size_t operator()(const BananSamplerInfo &info) const;
+    };
+
     class BananDevice {
     public:
         const bool enableValidationLayers = true;
@@ -34,9 +58,12 @@ namespace Banan {
         BananDevice(BananDevice &&) = delete;
         BananDevice &operator=(BananDevice &&) = delete;
 
+        // only for the render thread, everything else records through beginSingleTimeCommands
         VkCommandPool getCommandPool() { return commandPool; }
         VkDevice device() { return device_; }
         VkSurfaceKHR surface() { return surface_; }
+        // the queues are shared with every thread uploading through the device, go through queueSubmit and queuePresent
+        // instead of using them directly
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
         VkPhysicalDeviceProperties physicalDeviceProperties() { return properties; }
@@ -48,7 +75,14 @@ namespace Banan {
         VkFormat findSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
         VkSampleCountFlagBits getMaxUsableSampleCount();
 
+        VkResult queueSubmit(uint32_t submitCount, const VkSubmitInfo *submits, VkFence fence);
+        VkResult queuePresent(const VkPresentInfoKHR &presentInfo);
+        // vkDeviceWaitIdle needs every queue to itself
+        void waitIdle();
+
         void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory);
+        // safe from any thread, each one records from a pool of its own. the end call blocks until the commands have run,
+        // waiting threads have their commands batched into a single submit
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -59,6 +93,9 @@ namespace Banan {
 
         void createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory);
 
+        // samplers are owned by the device and shared between every image asking for the same state
+        VkSampler getSampler(const BananSamplerInfo &info);
+
     private:
         void createInstance();
         void setupDebugMessenger();
@@ -67,6 +104,24 @@ namespace Banan {
         void createLogicalDevice();
         void createCommandPool();
 
+        // every thread that records single time commands gets one, kept until the device goes away
+        struct ThreadCommandPool {
+            VkCommandPool commandPool;
+            std::vector<VkCommandBuffer> freeCommandBuffers;
+        };
+
+        // single time command buffers gathered from all threads while the queue was busy, submitted together under one fence
+        struct SubmitBatch {
+            VkDevice device;
+            VkFence fence = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> commandBuffers;
+
+            ~SubmitBatch();
+        };
+
+        ThreadCommandPool &threadCommandPool();
+        void submitAndWait(VkCommandBuffer commandBuffer);
+
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
         std::vector<const char *> getRequiredExtensions();
@@ -84,6 +139,16 @@ namespace Banan {
         BananWindow &window;
         VkCommandPool commandPool;
 
+        // tells this device's thread local pool cache apart from that of an earlier device at the same address
+        const uint64_t deviceId;
+
+        std::mutex threadPoolMutex;
+        std::unordered_map<std::thread::id, std::unique_ptr<ThreadCommandPool>> threadPools;
+
+        std::mutex queueMutex;
+        std::mutex batchMutex;
+        std::shared_ptr<SubmitBatch> openBatch;
+
         VkDevice device_;
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
@@ -91,6 +156,9 @@ namespace Banan {
 
         VkSampleCountFlagBits msaaSamples;
 
+        std::mutex samplerMutex;
+        std::unordered_map<BananSamplerInfo, VkSampler, BananSamplerInfoHash> samplerCache;
+
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME};
     };
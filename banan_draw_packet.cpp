@@ -0,0 +1,62 @@
+#include "banan_draw_packet.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Banan {
+
+    static_assert(BananDrawPacket::PASS_BITS + BananDrawPacket::PIPELINE_BITS + BananDrawPacket::MATERIAL_BITS + BananDrawPacket::DEPTH_BITS + BananDrawPacket::MESH_BITS == 64, "Draw key fields must fill 64 bits");
+
+    uint64_t BananDrawPacket::makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth, uint32_t mesh, bool backToFront) {
+        // non-negative floats order the same as their bits, the top bits below the sign keep the exponent and enough of the
+        // mantissa to tell apart depths a fraction of a percent apart
+        uint32_t depthBits;
+        std::memcpy(&depthBits, &depth, sizeof(depthBits));
+        depthBits = depth > 0.f ? (depthBits >> (31 - DEPTH_BITS)) : 0;
+        if (backToFront) {
+            depthBits = ~depthBits;
+        }
+
+        auto field = [](uint32_t value, uint32_t bits) { return static_cast<uint64_t>(value) & ((uint64_t{1} << bits) - 1); };
+
+        uint64_t key = field(pass, PASS_BITS);
+        key = (key << PIPELINE_BITS) | field(pipeline, PIPELINE_BITS);
+        key = (key << MATERIAL_BITS) | field(material, MATERIAL_BITS);
+        key = (key << DEPTH_BITS) | field(depthBits, DEPTH_BITS);
+        key = (key << MESH_BITS) | field(mesh, MESH_BITS);
+        return key;
+    }
+
+    void sortDrawPackets(std::vector<BananDrawPacket> &packets, std::vector<BananDrawPacket> &scratch) {
+        if (packets.size() < 2) {
+            return;
+        }
+
+        // every byte's histogram in one go
+        std::array<std::array<uint32_t, 256>, 8> counts{};
+        for (const auto &packet : packets) {
+            for (uint32_t byte = 0; byte < 8; byte++) {
+                counts[byte][(packet.key >> (byte * 8)) & 0xFF]++;
+            }
+        }
+
+        scratch.resize(packets.size());
+        for (uint32_t byte = 0; byte < 8; byte++) {
+            auto &count = counts[byte];
+            if (std::find(count.begin(), count.end(), packets.size()) != count.end()) continue;
+
+            std::array<uint32_t, 256> offsets;
+            uint32_t offset = 0;
+            for (uint32_t digit = 0; digit < 256; digit++) {
+                offsets[digit] = offset;
+                offset += count[digit];
+            }
+
+            for (const auto &packet : packets) {
+                scratch[offsets[(packet.key >> (byte * 8)) & 0xFF]++] = packet;
+            }
+            packets.swap(scratch);
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Banan {
+    // one draw a system wants to make this frame, index points back into whatever the system keeps per draw. sorting packets by
+    // key groups them by pass, then pipeline, then material, orders each group by depth and keeps draws of one mesh together
+    struct BananDrawPacket {
+        static constexpr uint32_t PASS_BITS = 4;
+        static constexpr uint32_t PIPELINE_BITS = 8;
+        static constexpr uint32_t MATERIAL_BITS = 16;
+        static constexpr uint32_t DEPTH_BITS = 20;
+        static constexpr uint32_t MESH_BITS = 16;
+
+        // depth is any non-negative distance from the camera, backToFront flips it for blended draws. fields are truncated
+        // to their bits
+        static uint64_t makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth, uint32_t mesh, bool backToFront = false);
+
+        static uint32_t pass(uint64_t key) { return static_cast<uint32_t>(key >> (64 - PASS_BITS)); }
+        static uint32_t pipeline(uint64_t key) { return static_cast<uint32_t>(key >> (64 - PASS_BITS - PIPELINE_BITS)) & ((1u << PIPELINE_BITS) - 1); }
+        static uint32_t material(uint64_t key) { return static_cast<uint32_t>(key >> (DEPTH_BITS + MESH_BITS)) & ((1u << MATERIAL_BITS) - 1); }
+        static uint32_t mesh(uint64_t key) { return static_cast<uint32_t>(key) & ((1u << MESH_BITS) - 1); }
+
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // stable lsd radix sort on the keys, a byte per pass. passes where every key has the same byte are skipped, which is most
+    // of the high ones since a frame rarely uses many passes or pipelines. scratch is only there to keep its allocation
+    void sortDrawPackets(std::vector<BananDrawPacket> &packets, std::vector<BananDrawPacket> &scratch);
+}
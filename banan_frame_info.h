@@ -17,6 +17,7 @@ namespace Banan {
         alignas(16) glm::mat4 inverseView{1.f};
         alignas(16) glm::vec4 ambientLightColor{1.f, 1.f, 1.f, 0.25f};
         int numGameObjects;
+        int frameNumber;
     };
 
     struct PointLightData {
@@ -38,6 +39,6 @@ namespace Banan {
         VkDescriptorSet edgeDetectionDescriptorSet;
         VkDescriptorSet blendWeightDescriptorSet;
         VkDescriptorSet resolveDescriptorSet;
-        BananGameObject::Map &gameObjects;
+        BananGameObjectManager &gameObjects;
     };
 }
\ No newline at end of file
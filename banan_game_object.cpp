@@ -4,25 +4,476 @@
 
 #include "banan_game_object.h"
 
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
 namespace Banan {
-    BananGameObject BananGameObject::createGameObject() {
-        static id_t currentId = 0;
-        return {currentId++};
+    TransformComponent &BananGameObject::transform() {
+        return get<TransformComponent>();
+    }
+
+    void BananGameObject::remove() {
+        assert(isAlive() && "Game object handle is stale");
+        gameObjectManager->destroyGameObject(id);
     }
 
-    BananGameObject::id_t BananGameObject::getId() {
-        return id;
+    BananGameObjectManager::BananGameObjectManager(BananDevice &device, uint32_t maxGameObjects) : bananDevice{device}, maxGameObjects{maxGameObjects}, textureSlots{device, maxGameObjects}, normalSlots{device, maxGameObjects}, heightSlots{device, maxGameObjects} {
+        for (auto &buffer : objectBuffers) {
+            buffer = std::make_unique<BananBuffer>(bananDevice, sizeof(GameObjectData), maxGameObjects, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            buffer->map();
+        }
+
+        dirtyMasks.reserve(maxGameObjects);
+        parents.reserve(maxGameObjects);
+        children.reserve(maxGameObjects);
+        generations.reserve(maxGameObjects);
+        materialSlots.reserve(maxGameObjects);
     }
 
-    BananGameObject BananGameObject::makePointLight(float intensity, float radius, glm::vec3 color) {
-        BananGameObject obj = BananGameObject::createGameObject();
-        obj.color = color;
-        obj.transform.scale.x = radius;
-        obj.pointLight = std::make_unique<PointLightComponent>();
-        obj.pointLight->lightIntensity = intensity;
+    BananGameObject BananGameObjectManager::createGameObject() {
+        BananGameObject::id_t id;
+        if (!freeIds.empty()) {
+            std::pop_heap(freeIds.begin(), freeIds.end(), std::greater<>{});
+            id = freeIds.back();
+            freeIds.pop_back();
+        } else {
+            assert(currentId < maxGameObjects && "Max game object count exceeded");
+            id = currentId++;
+            dirtyMasks.push_back(0);
+            parents.push_back(BananGameObject::NO_PARENT);
+            children.emplace_back();
+            generations.push_back(0);
+            materialSlots.emplace_back();
+        }
+
+        BananGameObject obj{id, generations[id], *this};
+
+        // new objects are roots appended after everything else, which keeps the pool in hierarchy order
+        transforms.add(id);
+        markDirty(id);
+        hierarchyParents.push_back(NO_PARENT_INDEX);
+        worldChanged.push_back(0);
+        inHierarchy.push_back(0);
+        worldMatrices.emplace_back(1.f);
+        worldNormalMatrices.emplace_back(1.f);
         return obj;
     }
 
+    BananGameObject BananGameObjectManager::makePointLight(float intensity, float radius, glm::vec3 color) {
+        BananGameObject obj = createGameObject();
+        obj.transform().scale.x = radius;
+        obj.add<PointLightComponent>({intensity, color});
+        return obj;
+    }
+
+    void BananGameObjectManager::destroyGameObject(BananGameObject::id_t id) {
+        assert(transforms.has(id) && "Game object was already destroyed");
+
+        drawChangeCount += models.has(id);
+
+        // orphans become roots where they are, a root can sit anywhere in the pool's order
+        for (auto child : children[id]) {
+            parents[child] = BananGameObject::NO_PARENT;
+            hierarchyParents[transforms.index(child)] = NO_PARENT_INDEX;
+            updateInHierarchy(child);
+            markDirty(child);
+        }
+        children[id].clear();
+
+        auto parent = parents[id];
+        parents[id] = BananGameObject::NO_PARENT;
+        if (parent != BananGameObject::NO_PARENT) {
+            std::erase(children[parent], id);
+            updateInHierarchy(parent);
+        }
+
+        removeTransform(id);
+        models.remove(id);
+        materials.remove(id);
+        parallaxes.remove(id);
+        pointLights.remove(id);
+        bvh.remove(id);
+        releaseTextureSlots(id);
+
+        // the record gets rewritten as an empty object, so shaders indexing it never see stale data
+        markDirty(id);
+
+        generations[id]++;
+        freeIds.push_back(id);
+        std::push_heap(freeIds.begin(), freeIds.end(), std::greater<>{});
+    }
+
+    BananGameObject BananGameObjectManager::getGameObject(BananGameObject::id_t id) {
+        return {id, generations[id], *this};
+    }
+
+    void BananGameObjectManager::markDirty(BananGameObject::id_t id) {
+        dirtyMasks[id] |= TRANSFORM_DIRTY_BIT;
+        queueUpload(id);
+    }
+
+    void BananGameObjectManager::queueUpload(BananGameObject::id_t id) {
+        uint8_t &mask = dirtyMasks[id];
+        for (uint8_t frame = 0; frame < BananSwapChain::MAX_FRAMES_IN_FLIGHT; frame++) {
+            if ((mask & (1 << frame)) == 0) {
+                mask |= 1 << frame;
+                dirtyIds[frame].push_back(id);
+            }
+        }
+    }
+
+    void BananGameObjectManager::setParent(BananGameObject::id_t child, BananGameObject::id_t parent) {
+        assert(transforms.has(child) && "Child must have a transform");
+        assert((parent == BananGameObject::NO_PARENT || transforms.has(parent)) && "Parent must have a transform");
+
+        for (auto ancestor = parent; ancestor != BananGameObject::NO_PARENT; ancestor = parents[ancestor]) {
+            assert(ancestor != child && "Parenting would create a cycle");
+        }
+
+        auto oldParent = parents[child];
+        if (oldParent == parent) {
+            return;
+        }
+
+        if (oldParent != BananGameObject::NO_PARENT) {
+            std::erase(children[oldParent], child);
+        }
+        parents[child] = parent;
+
+        uint32_t childIndex = transforms.index(child);
+        if (parent == BananGameObject::NO_PARENT) {
+            hierarchyParents[childIndex] = NO_PARENT_INDEX;
+        } else {
+            children[parent].push_back(child);
+
+            // the child's descendants already sit behind it, so the order only breaks when the new parent does too
+            uint32_t parentIndex = transforms.index(parent);
+            hierarchyParents[childIndex] = parentIndex;
+            if (parentIndex > childIndex) {
+                hierarchyChanged = true;
+            }
+        }
+
+        updateInHierarchy(child);
+        if (oldParent != BananGameObject::NO_PARENT) {
+            updateInHierarchy(oldParent);
+        }
+        if (parent != BananGameObject::NO_PARENT) {
+            updateInHierarchy(parent);
+        }
+
+        // descendants pick the change up through worldChanged, nothing else moved
+        markDirty(child);
+    }
+
+    void BananGameObjectManager::removeTransform(BananGameObject::id_t id) {
+        // the last transform fills the hole like in the pool. being last in hierarchy order it has no children, so it only breaks
+        // the order when its parent sits behind the hole
+        uint32_t index = transforms.index(id);
+        uint32_t last = static_cast<uint32_t>(transforms.size() - 1);
+        transforms.remove(id);
+
+        if (index != last) {
+            hierarchyParents[index] = hierarchyParents[last];
+            worldChanged[index] = worldChanged[last];
+            inHierarchy[index] = inHierarchy[last];
+            worldMatrices[index] = worldMatrices[last];
+            worldNormalMatrices[index] = worldNormalMatrices[last];
+            if (hierarchyParents[index] != NO_PARENT_INDEX && hierarchyParents[index] > index) {
+                hierarchyChanged = true;
+            }
+        }
+
+        hierarchyParents.pop_back();
+        worldChanged.pop_back();
+        inHierarchy.pop_back();
+        worldMatrices.pop_back();
+        worldNormalMatrices.pop_back();
+    }
+
+    void BananGameObjectManager::updateInHierarchy(BananGameObject::id_t id) {
+        uint8_t linked = parents[id] != BananGameObject::NO_PARENT || !children[id].empty();
+
+        // only objects outside a hierarchy get their matrices built on the gpu, so switching sides needs a new record
+        uint32_t index = transforms.index(id);
+        if (inHierarchy[index] != linked) {
+            inHierarchy[index] = linked;
+            markDirty(id);
+        }
+    }
+
+    void BananGameObjectManager::rebuildHierarchy() {
+        auto &ids = transforms.ids();
+
+        std::vector<BananGameObject::id_t> order;
+        order.reserve(ids.size());
+        for (auto id : ids) {
+            if (parents[id] == BananGameObject::NO_PARENT) {
+                order.push_back(id);
+            }
+        }
+        for (size_t head = 0; head < order.size(); head++) {
+            auto id = order[head];
+            order.insert(order.end(), children[id].begin(), children[id].end());
+        }
+
+        // the per transform arrays move along with their transforms, nothing gets recomputed so nothing needs to be dirtied
+        std::vector<uint32_t> previous(order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            previous[i] = transforms.index(order[i]);
+        }
+
+        transforms.sort(order);
+
+        auto permute = [&previous](auto &values) {
+            std::remove_reference_t<decltype(values)> sorted;
+            sorted.reserve(values.size());
+            for (uint32_t index : previous) {
+                sorted.push_back(values[index]);
+            }
+            values.swap(sorted);
+        };
+        permute(inHierarchy);
+        permute(worldMatrices);
+        permute(worldNormalMatrices);
+
+        worldChanged.assign(order.size(), 0);
+        for (size_t i = 0; i < order.size(); i++) {
+            auto parent = parents[order[i]];
+            hierarchyParents[i] = parent == BananGameObject::NO_PARENT ? NO_PARENT_INDEX : transforms.index(parent);
+        }
+
+        hierarchyChanged = false;
+    }
+
+    void BananGameObjectManager::setGpuTransforms(bool enabled) {
+        if (gpuTransforms == enabled) {
+            return;
+        }
+
+        gpuTransforms = enabled;
+        for (auto id : transforms.ids()) {
+            markDirty(id);
+        }
+    }
+
+    void BananGameObjectManager::updateTransforms() {
+        if (hierarchyChanged) {
+            rebuildHierarchy();
+        }
+
+        auto &ids = transforms.ids();
+        auto &data = transforms.data();
+
+        transformBatch.clear();
+        changedTransforms.clear();
+        for (size_t i = 0; i < ids.size(); i++) {
+            uint32_t parent = hierarchyParents[i];
+            uint8_t &mask = dirtyMasks[ids[i]];
+
+            // parents always come first, so their changed flag for this frame is already known
+            bool changed = (mask & TRANSFORM_DIRTY_BIT) || (parent != NO_PARENT_INDEX && worldChanged[parent]);
+            worldChanged[i] = changed;
+            if (!changed) continue;
+
+            // lights move every frame without touching what the g-buffer draws
+            drawChangeCount += models.has(ids[i]);
+
+            // the bit is set by any mutable access, so this is also where material changes are picked up
+            if (mask & TRANSFORM_DIRTY_BIT) {
+                updateTextureSlots(ids[i]);
+            }
+            mask &= ~TRANSFORM_DIRTY_BIT;
+
+            // the compute pass builds these from the uploaded record
+            if (gpuTransforms && !inHierarchy[i]) {
+                updateBounds(static_cast<uint32_t>(i));
+                queueUpload(ids[i]);
+                continue;
+            }
+
+            changedTransforms.push_back(static_cast<uint32_t>(i));
+            transformBatch.push(data[i]);
+        }
+
+        if (changedTransforms.empty()) {
+            bvh.commit();
+            return;
+        }
+
+        localMatrices.resize(changedTransforms.size());
+        localNormalMatrices.resize(changedTransforms.size());
+        transformBatch.compute(localMatrices.data(), localNormalMatrices.data());
+
+        // changed transforms are still in hierarchy order, so parents are composed before their children
+        for (size_t j = 0; j < changedTransforms.size(); j++) {
+            uint32_t i = changedTransforms[j];
+            uint32_t parent = hierarchyParents[i];
+
+            if (parent == NO_PARENT_INDEX) {
+                worldMatrices[i] = localMatrices[j];
+                worldNormalMatrices[i] = localNormalMatrices[j];
+            } else {
+                worldMatrices[i] = worldMatrices[parent] * localMatrices[j];
+                worldNormalMatrices[i] = worldNormalMatrices[parent] * localNormalMatrices[j];
+            }
+
+            updateBounds(i);
+            queueUpload(ids[i]);
+        }
+
+        bvh.commit();
+    }
+
+    void BananGameObjectManager::updateBounds(uint32_t index) {
+        auto id = transforms.ids()[index];
+        auto &transform = transforms.data()[index];
+        bool gpuTransform = gpuTransforms && !inHierarchy[index];
+        glm::vec3 position = gpuTransform ? transform.translation : glm::vec3(worldMatrices[index][3]);
+
+        if (pointLights.has(id)) {
+            glm::vec3 radius{transform.scale.x};
+            bvh.update(id, {position - radius, position + radius});
+            return;
+        }
+
+        if (!models.has(id) || !models.get(id).model->getBounds().isValid()) {
+            bvh.remove(id);
+            return;
+        }
+
+        const BananAABB &localBounds = models.get(id).model->getBounds();
+        if (!gpuTransform) {
+            bvh.update(id, localBounds.transformed(worldMatrices[index]));
+            return;
+        }
+
+        // there's no world matrix on the cpu for these, so use a box that holds the model under any rotation
+        glm::vec3 scale = glm::abs(transform.scale);
+        glm::vec3 farthest = glm::max(glm::abs(localBounds.min), glm::abs(localBounds.max));
+        glm::vec3 radius{glm::length(farthest) * std::max({scale.x, scale.y, scale.z})};
+        bvh.update(id, {position - radius, position + radius});
+    }
+
+    void BananGameObjectManager::updateTextureSlots(BananGameObject::id_t id) {
+        auto &held = materialSlots[id];
+        MaterialComponent *material = materials.has(id) ? &materials.get(id) : nullptr;
+
+        auto sync = [](BananTextureSlots &slots, uint32_t &slot, const std::shared_ptr<BananImage> &image) {
+            const BananImage *current = slot != BananTextureSlots::NO_SLOT ? slots.getImage(slot) : nullptr;
+            if (current == image.get()) return;
+
+            if (slot != BananTextureSlots::NO_SLOT) slots.release(slot);
+            slot = image != nullptr ? slots.acquire(image) : BananTextureSlots::NO_SLOT;
+        };
+
+        static const std::shared_ptr<BananImage> none{};
+        sync(textureSlots, held.texture, material != nullptr ? material->texture : none);
+        sync(normalSlots, held.normal, material != nullptr ? material->normal : none);
+        sync(heightSlots, held.height, material != nullptr ? material->height : none);
+    }
+
+    void BananGameObjectManager::releaseTextureSlots(BananGameObject::id_t id) {
+        auto &held = materialSlots[id];
+        if (held.texture != BananTextureSlots::NO_SLOT) textureSlots.release(held.texture);
+        if (held.normal != BananTextureSlots::NO_SLOT) normalSlots.release(held.normal);
+        if (held.height != BananTextureSlots::NO_SLOT) heightSlots.release(held.height);
+        held = {};
+    }
+
+    void BananGameObjectManager::writeTextureDescriptors(int frameIndex, VkDescriptorSet textureSet, VkDescriptorSet normalSet, VkDescriptorSet heightSet) {
+        textureSlots.writeDescriptors(frameIndex, textureSet);
+        normalSlots.writeDescriptors(frameIndex, normalSet);
+        heightSlots.writeDescriptors(frameIndex, heightSet);
+    }
+
+    VkDescriptorBufferInfo BananGameObjectManager::getBufferInfo(int frameIndex) {
+        return objectBuffers[frameIndex]->descriptorInfo();
+    }
+
+    void BananGameObjectManager::updateBuffer(int frameIndex) {
+        textureSlots.advanceFrame();
+        normalSlots.advanceFrame();
+        heightSlots.advanceFrame();
+
+        updateTransforms();
+
+        auto &ids = dirtyIds[frameIndex];
+        if (ids.empty()) {
+            return;
+        }
+
+        std::sort(ids.begin(), ids.end());
+
+        auto *data = static_cast<GameObjectData *>(objectBuffers[frameIndex]->getMappedMemory());
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        for (auto id : ids) {
+            data[id] = buildObjectData(id);
+            dirtyMasks[id] &= ~(1 << frameIndex);
+
+            if (!ranges.empty() && ranges.back().first + ranges.back().second == id) {
+                ranges.back().second++;
+            } else {
+                ranges.emplace_back(id, 1);
+            }
+        }
+
+        objectBuffers[frameIndex]->flushIndexRanges(ranges);
+        ids.clear();
+    }
+
+    GameObjectData BananGameObjectManager::buildObjectData(BananGameObject::id_t id) {
+        GameObjectData objectData{};
+        if (!transforms.has(id)) {
+            return objectData;
+        }
+
+        uint32_t index = transforms.index(id);
+        auto &transform = transforms.data()[index];
+
+        bool gpuTransform = gpuTransforms && !inHierarchy[index];
+        objectData.position = glm::vec4(gpuTransform ? transform.translation : glm::vec3(worldMatrices[index][3]), 0.f);
+        objectData.rotation = glm::vec4(transform.rotation, 0.f);
+        objectData.scale = glm::vec4(transform.scale, 0.f);
+
+        if (pointLights.has(id)) {
+            auto &light = pointLights.get(id);
+            objectData.rotation = glm::vec4(light.color, light.lightIntensity);
+            objectData.scale = glm::vec4(transform.scale.x, -1.f, -1.f, -1.f);
+            objectData.isPointLight = 1;
+            return objectData;
+        }
+
+        if (gpuTransform) {
+            objectData.position.w = 1.f;
+        } else {
+            objectData.modelMatrix = worldMatrices[index];
+            objectData.normalMatrix = glm::mat4{worldNormalMatrices[index]};
+        }
+
+        if (materials.has(id)) {
+            auto &material = materials.get(id);
+            objectData.uvTransform = material.uvTransform;
+            objectData.normalUvTransform = material.normalUvTransform;
+            objectData.heightUvTransform = material.heightUvTransform;
+            auto &held = materialSlots[id];
+            objectData.textureLocation = held.texture != BananTextureSlots::NO_SLOT ? static_cast<int>(held.texture) : -1;
+            objectData.normalLocation = held.normal != BananTextureSlots::NO_SLOT ? static_cast<int>(held.normal) : -1;
+            objectData.heightLocation = held.height != BananTextureSlots::NO_SLOT ? static_cast<int>(held.height) : -1;
+        }
+
+        if (parallaxes.has(id)) {
+            auto &parallax = parallaxes.get(id);
+            objectData.heightscale = parallax.heightscale;
+            objectData.parallaxBias = parallax.parallaxBias;
+            objectData.numLayers = parallax.numLayers;
+            objectData.parallaxmode = parallax.parallaxmode;
+        }
+
+        return objectData;
+    }
+
     glm::mat4 TransformComponent::mat4() {
         const float c3 = glm::cos(rotation.z);
         const float s3 = glm::sin(rotation.z);
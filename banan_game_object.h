@@ -6,11 +6,18 @@
 
 #include "banan_swap_chain.h"
 #include "banan_model.h"
+#include "banan_buffer.h"
+#include "banan_transform_batch.h"
+#include "banan_bvh.h"
+#include "banan_texture_slots.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cassert>
+#include <limits>
 #include <memory>
-#include <unordered_map>
+#include <type_traits>
+#include <vector>
 
 namespace Banan {
 
@@ -18,12 +25,25 @@ namespace Banan {
         glm::vec3 translation{};
         glm::vec3 scale{1.f, 1.f, 1.f};
         glm::vec3 rotation{};
-        int id;
 
         glm::mat4 mat4();
         glm::mat3 normalMatrix();
     };
 
+    struct ModelComponent {
+        std::shared_ptr<BananModel> model{};
+    };
+
+    struct MaterialComponent {
+        std::shared_ptr<BananImage> texture;
+        std::shared_ptr<BananImage> normal;
+        std::shared_ptr<BananImage> height;
+        // where each map sits inside its image, xy scale and zw offset. identity unless the image is an atlas page
+        glm::vec4 uvTransform{1.f, 1.f, 0.f, 0.f};
+        glm::vec4 normalUvTransform{1.f, 1.f, 0.f, 0.f};
+        glm::vec4 heightUvTransform{1.f, 1.f, 0.f, 0.f};
+    };
+
     struct ParallaxComponent {
         float heightscale = -1.f;
         float parallaxBias = -1.f;
@@ -33,79 +53,309 @@ namespace Banan {
 
     struct PointLightComponent {
         float lightIntensity = 1.0f;
+        glm::vec3 color{1.f};
     };
 
+    // mirrors the GameObject struct in the shaders (std430)
     struct GameObjectData {
+        alignas(16) glm::vec4 position{0.f};
+        alignas(16) glm::vec4 rotation{0.f}; // color for point lights
+        alignas(16) glm::vec4 scale{1.f}; // radius for point lights
+        alignas(16) glm::vec4 uvTransform{1.f, 1.f, 0.f, 0.f};
+        alignas(16) glm::vec4 normalUvTransform{1.f, 1.f, 0.f, 0.f};
+        alignas(16) glm::vec4 heightUvTransform{1.f, 1.f, 0.f, 0.f};
+
         alignas(16) glm::mat4 modelMatrix{1.f};
         alignas(16) glm::mat4 normalMatrix{1.f};
 
+        // slots in the bindless texture, normal and height arrays
         int textureLocation = -1;
         int normalLocation = -1;
         int heightLocation = -1;
 
-        float heightscale = 0.1;
-        float parallaxBias = -0.02f;
-        float numLayers = 48.0f;
-        int parallaxmode = 1;
-    };
+        float heightscale = -1.f;
+        float parallaxBias = -1.f;
+        float numLayers = -1.f;
+        int parallaxmode = -1;
 
-    class BananGameObjectManager;
+        int isPointLight = 0;
+    };
 
-    class BananGameObject {
+    // sparse set, components sit densely packed in insertion order and the sparse array maps an id to its dense slot
+    template<typename T>
+    class BananComponentPool {
         public:
             using id_t = unsigned int;
-            using Map = std::unordered_map<id_t, BananGameObject>;
+            static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+            T &add(id_t id, T component = {}) {
+                if (id >= sparse.size()) {
+                    sparse.resize(id + 1, INVALID_INDEX);
+                }
+
+                assert(sparse[id] == INVALID_INDEX && "Component already added to game object");
+                sparse[id] = static_cast<uint32_t>(dense.size());
+                dense.push_back(id);
+                components.push_back(std::move(component));
+                return components.back();
+            }
 
-            static BananGameObject createGameObject();
-            static BananGameObject makePointLight(float intensity = 10.0f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+            // swaps the last component into the hole so the arrays stay packed
+            void remove(id_t id) {
+                if (!has(id)) return;
 
-            BananGameObject(BananGameObject &&) = default;
-            BananGameObject(const BananGameObject &) = delete;
-            BananGameObject &operator=(const BananGameObject &) = delete;
-            BananGameObject &operator=(BananGameObject &&) = delete;
+                uint32_t index = sparse[id];
+                id_t last = dense.back();
 
-            id_t getId();
+                components[index] = std::move(components.back());
+                dense[index] = last;
+                sparse[last] = index;
+
+                components.pop_back();
+                dense.pop_back();
+                sparse[id] = INVALID_INDEX;
+            }
+
+            bool has(id_t id) const { return id < sparse.size() && sparse[id] != INVALID_INDEX; }
+
+            T &get(id_t id) {
+                assert(has(id) && "Game object does not have this component");
+                return components[sparse[id]];
+            }
+
+            uint32_t index(id_t id) const {
+                assert(has(id) && "Game object does not have this component");
+                return sparse[id];
+            }
+
+            // reorders the dense arrays to match order, which has to hold every id in the pool exactly once
+            void sort(const std::vector<id_t> &order) {
+                assert(order.size() == dense.size() && "Sort order must contain every component");
+
+                std::vector<T> sorted;
+                sorted.reserve(components.size());
+                for (id_t id : order) {
+                    sorted.push_back(std::move(components[sparse[id]]));
+                }
+
+                for (size_t i = 0; i < order.size(); i++) {
+                    sparse[order[i]] = static_cast<uint32_t>(i);
+                }
+
+                dense = order;
+                components = std::move(sorted);
+            }
+
+            size_t size() const { return dense.size(); }
+            const std::vector<id_t> &ids() const { return dense; }
+            std::vector<T> &data() { return components; }
+
+        private:
+            std::vector<uint32_t> sparse;
+            std::vector<id_t> dense;
+            std::vector<T> components;
+    };
+
+    class BananGameObjectManager;
 
-            GameObjectData getObjectData(int frameIndex);
+    // a handle into the manager, the components themselves live in the manager's pools. ids are recycled once an object is
+    // destroyed, the generation tells a handle to the old object apart from one to whatever reused its id
+    class BananGameObject {
+        public:
+            using id_t = unsigned int;
+            static constexpr id_t NO_PARENT = std::numeric_limits<id_t>::max();
 
-            glm::vec3 color{};
-            TransformComponent transform{};
-            ParallaxComponent parallax{};
+            id_t getId() const { return id; }
+            uint32_t getGeneration() const { return generation; }
+            bool isAlive() const;
 
-            std::shared_ptr<BananImage> texture;
-            std::shared_ptr<BananImage> normal;
-            std::shared_ptr<BananImage> height;
+            // mutable access goes through the manager's dirty tracking, so the record is re-uploaded
+            template<typename T> T &add(T component = {});
+            template<typename T> T &get();
+            // for code that only looks, doesn't mark the object dirty
+            template<typename T> const T &read() const;
+            template<typename T> bool has() const;
+            void remove();
+            void setParent(const BananGameObject &parent);
 
-            std::shared_ptr<BananModel> model{};
-            std::unique_ptr<PointLightComponent> pointLight = nullptr;
+            TransformComponent &transform();
 
         private:
-            BananGameObject(id_t objId, const BananGameObjectManager &manager);
+            BananGameObject(id_t objId, uint32_t objGeneration, BananGameObjectManager &manager) : id{objId}, generation{objGeneration}, gameObjectManager{&manager} {}
 
             id_t id;
-            const BananGameObjectManager &gameObjectManger;
+            uint32_t generation;
+            BananGameObjectManager *gameObjectManager;
 
             friend class BananGameObjectManager;
     };
 
     class BananGameObjectManager {
         public:
-            BananGameObjectManager(BananDevice &device);
+            BananGameObjectManager(BananDevice &device, uint32_t maxGameObjects);
             BananGameObjectManager(const BananGameObjectManager &) = delete;
             BananGameObjectManager &operator=(const BananGameObjectManager &) = delete;
             BananGameObjectManager(BananGameObjectManager &&) = delete;
             BananGameObjectManager &operator=(BananGameObjectManager &&) = delete;
 
-            BananGameObject& createGameObject();
-            BananGameObject &makePointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
-            VkDescriptorBufferInfo getUboBufferInfo();
+            BananGameObject createGameObject();
+            BananGameObject makePointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+            // the id goes back on the free list, handles to the object stop being alive
+            void destroyGameObject(BananGameObject::id_t id);
+            // a handle to whatever currently lives at id
+            BananGameObject getGameObject(BananGameObject::id_t id);
+            bool isAlive(BananGameObject::id_t id, uint32_t generation) const { return id < generations.size() && generations[id] == generation && transforms.has(id); }
+
+            template<typename T> BananComponentPool<T> &pool() {
+                if constexpr (std::is_same_v<T, TransformComponent>) return transforms;
+                else if constexpr (std::is_same_v<T, ModelComponent>) return models;
+                else if constexpr (std::is_same_v<T, MaterialComponent>) return materials;
+                else if constexpr (std::is_same_v<T, ParallaxComponent>) return parallaxes;
+                else if constexpr (std::is_same_v<T, PointLightComponent>) return pointLights;
+                else static_assert(sizeof(T) == 0, "Unknown component type");
+            }
+
+            // walks the first component's dense array and skips ids missing any of the others, so put the rarest component first
+            // this doesn't know what the callback writes, call markDirty for every object that's changed
+            template<typename T, typename... Others, typename Func>
+            void each(Func &&func) {
+                auto &first = pool<T>();
+                auto &ids = first.ids();
+                auto &components = first.data();
+                for (size_t i = 0; i < ids.size(); i++) {
+                    if ((pool<Others>().has(ids[i]) && ...)) {
+                        func(ids[i], components[i], pool<Others>().get(ids[i])...);
+                    }
+                }
+            }
+
+            // children inherit the parent's world transform, pass NO_PARENT to make the object a root again
+            void setParent(BananGameObject::id_t child, BananGameObject::id_t parent);
+            BananGameObject::id_t getParent(BananGameObject::id_t id) const { return parents[id]; }
+
+            // world matrices are only valid after updateTransforms, updateBuffer calls it before uploading
+            void updateTransforms();
+            const glm::mat4 &getWorldMatrix(BananGameObject::id_t id) const { return worldMatrices[transforms.index(id)]; }
 
+            // objects outside any hierarchy only upload translation, rotation and scale and calc_normal_mats.comp builds their
+            // matrices, getWorldMatrix isn't kept up to date for them while this is on
+            void setGpuTransforms(bool enabled);
+            bool usesGpuTransforms() const { return gpuTransforms; }
+
+            // world space boxes of everything with a model or a point light, updateTransforms refits it for whatever moved
+            const BananBVH &getBvh() const { return bvh; }
+            // bumped whenever an object with a model is created, changed, moved or destroyed, so a draw list built from the
+            // objects can tell it's still current. only up to date after updateTransforms
+            uint64_t getDrawChangeCount() const { return drawChangeCount; }
+
+            // objects are indexed by id in the storage buffer, so this is also the number of records the shaders can see.
+            // the lowest free id is always reused first, which keeps this close to the number of live objects
+            uint32_t size() const { return currentId; }
+
+            // queues the object's record for upload into every frame's buffer
+            void markDirty(BananGameObject::id_t id);
+
+            VkDescriptorBufferInfo getBufferInfo(int frameIndex);
+            // only rewrites the records that changed since this frame's buffer was last updated
             void updateBuffer(int frameIndex);
 
-            BananGameObject::Map gameObjects{};
-            std::vector<std::unique_ptr<BananBuffer>> uboBuffers{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
+            // points this frame's bindless arrays at every texture that got a slot since they were last written
+            void writeTextureDescriptors(int frameIndex, VkDescriptorSet textureSet, VkDescriptorSet normalSet, VkDescriptorSet heightSet);
+            uint32_t getTextureSlotCapacity() const { return textureSlots.getCapacity(); }
 
         private:
+            static constexpr uint8_t TRANSFORM_DIRTY_BIT = 1 << 7;
+            static constexpr uint32_t NO_PARENT_INDEX = std::numeric_limits<uint32_t>::max();
+            static_assert(BananSwapChain::MAX_FRAMES_IN_FLIGHT < 7, "dirty masks hold one bit per frame plus the transform bit");
+
+            void queueUpload(BananGameObject::id_t id);
+            void rebuildHierarchy();
+            void removeTransform(BananGameObject::id_t id);
+            void updateInHierarchy(BananGameObject::id_t id);
+            void updateBounds(uint32_t index);
+            void updateTextureSlots(BananGameObject::id_t id);
+            void releaseTextureSlots(BananGameObject::id_t id);
+            GameObjectData buildObjectData(BananGameObject::id_t id);
+
+            BananDevice &bananDevice;
+            uint32_t maxGameObjects;
             BananGameObject::id_t currentId = 0;
+
+            std::vector<uint32_t> generations;
+            std::vector<BananGameObject::id_t> freeIds; // min heap
+
+            BananComponentPool<TransformComponent> transforms;
+            BananComponentPool<ModelComponent> models;
+            BananComponentPool<MaterialComponent> materials;
+            BananComponentPool<ParallaxComponent> parallaxes;
+            BananComponentPool<PointLightComponent> pointLights;
+
+            std::vector<std::unique_ptr<BananBuffer>> objectBuffers{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
+
+            // one bit per frame in flight, an id is only in a frame's list while its bit is set
+            std::vector<uint8_t> dirtyMasks;
+            std::vector<std::vector<BananGameObject::id_t>> dirtyIds{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
+
+            // parent and child ids are kept per id, everything else runs parallel to the transform pool, which is kept in breadth first
+            // order so a parent's world matrix is always computed before its children's in one forward sweep
+            std::vector<BananGameObject::id_t> parents;
+            std::vector<std::vector<BananGameObject::id_t>> children;
+            std::vector<uint32_t> hierarchyParents;
+            std::vector<uint8_t> worldChanged;
+            std::vector<uint8_t> inHierarchy;
+            std::vector<glm::mat4> worldMatrices;
+            std::vector<glm::mat3> worldNormalMatrices;
+            bool hierarchyChanged = false;
+            bool gpuTransforms = false;
+            uint64_t drawChangeCount = 0;
+
+            // scratch for the batched local matrix pass, kept around so a frame doesn't reallocate
+            BananTransformBatch transformBatch;
+            std::vector<uint32_t> changedTransforms;
+            std::vector<glm::mat4> localMatrices;
+            std::vector<glm::mat3> localNormalMatrices;
+
+            BananBVH bvh;
+
+            // slots held by each object's material, indexed by id
+            struct MaterialSlots {
+                uint32_t texture = BananTextureSlots::NO_SLOT;
+                uint32_t normal = BananTextureSlots::NO_SLOT;
+                uint32_t height = BananTextureSlots::NO_SLOT;
+            };
+
+            BananTextureSlots textureSlots;
+            BananTextureSlots normalSlots;
+            BananTextureSlots heightSlots;
+            std::vector<MaterialSlots> materialSlots;
     };
-}
\ No newline at end of file
+
+    inline bool BananGameObject::isAlive() const {
+        return gameObjectManager->isAlive(id, generation);
+    }
+
+    inline void BananGameObject::setParent(const BananGameObject &parent) {
+        gameObjectManager->setParent(id, parent.id);
+    }
+
+    template<typename T> T &BananGameObject::add(T component) {
+        assert(isAlive() && "Game object handle is stale");
+        gameObjectManager->markDirty(id);
+        return gameObjectManager->pool<T>().add(id, std::move(component));
+    }
+
+    template<typename T> T &BananGameObject::get() {
+        assert(isAlive() && "Game object handle is stale");
+        gameObjectManager->markDirty(id);
+        return gameObjectManager->pool<T>().get(id);
+    }
+
+    template<typename T> const T &BananGameObject::read() const {
+        assert(isAlive() && "Game object handle is stale");
+        return gameObjectManager->pool<T>().get(id);
+    }
+
+    template<typename T> bool BananGameObject::has() const {
+        return gameObjectManager->pool<T>().has(id);
+    }
+}
@@ -33,7 +33,6 @@ namespace Banan {
     }
 
     BananImage::~BananImage() {
-        vkDestroySampler(bananDevice.device(), imageSampler, nullptr);
         vkDestroyImageView(bananDevice.device(), imageView, nullptr);
         vkDestroyImage(bananDevice.device(), image, nullptr);
         vkFreeMemory(bananDevice.device(), memory, nullptr);
@@ -71,30 +70,9 @@ namespace Banan {
     }
 
     void BananImage::createTextureSampler() {
-        VkSamplerCreateInfo samplerInfo{};
-        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-        samplerInfo.magFilter = VK_FILTER_LINEAR;
-        samplerInfo.minFilter = VK_FILTER_LINEAR;
-        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-
-        samplerInfo.anisotropyEnable = VK_TRUE;
+        BananSamplerInfo samplerInfo{};
         samplerInfo.maxAnisotropy = bananDevice.physicalDeviceProperties().limits.maxSamplerAnisotropy;
-
-        samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-        samplerInfo.unnormalizedCoordinates = VK_FALSE;
-        samplerInfo.compareEnable = VK_FALSE;
-        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-
-        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        samplerInfo.mipLodBias = 0.0f;
-        samplerInfo.minLod = 0.0f;
-        samplerInfo.maxLod = static_cast<float>(mipLevels);
-
-        if (vkCreateSampler(bananDevice.device(), &samplerInfo, nullptr, &imageSampler) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create texture sampler!");
-        }
+        imageSampler = bananDevice.getSampler(samplerInfo);
     }
 
     void BananImage::transitionLayout(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout) {
@@ -158,7 +136,6 @@ namespace Banan {
     }
 
     BananCubemap::~BananCubemap() {
-        vkDestroySampler(bananDevice.device(), cubemapImageSampler, nullptr);
         vkDestroyImageView(bananDevice.device(), cubemapImageView, nullptr);
         vkDestroyImage(bananDevice.device(), cubemapImage, nullptr);
         vkFreeMemory(bananDevice.device(), memory, nullptr);
@@ -180,24 +157,13 @@ namespace Banan {
     }
 
     void BananCubemap::createTextureSampler() {
-        VkSamplerCreateInfo samplerCreateInfo{};
-        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-        samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
-        samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
-        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
-        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
-        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
-        samplerCreateInfo.mipLodBias = 0.0f;
-        samplerCreateInfo.maxAnisotropy = 1.0f;
-        samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
-        samplerCreateInfo.minLod = 0.0f;
-        samplerCreateInfo.maxLod = 1.0f;
-        samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-
-        if (vkCreateSampler(bananDevice.device(), &samplerCreateInfo, nullptr, &cubemapImageSampler) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create cubemap sampler");
-        }
+        BananSamplerInfo samplerInfo{};
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.maxLod = 1.0f;
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        cubemapImageSampler = bananDevice.getSampler(samplerInfo);
     }
 
     VkDescriptorImageInfo BananCubemap::descriptorInfo() {
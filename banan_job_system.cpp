@@ -0,0 +1,182 @@
+#include "banan_job_system.h"
+
+#include <algorithm>
+
+namespace Banan {
+
+    // which queue the calling thread owns, threads outside any pool share the last one
+    static thread_local const BananJobSystem *currentSystem = nullptr;
+    static thread_local uint32_t currentWorker = 0;
+
+    BananJobSystem::BananJobSystem(uint32_t workerCount) {
+        workerCount = std::max(workerCount, 1u);
+
+        queues.reserve(workerCount + 1);
+        for (uint32_t i = 0; i < workerCount + 1; i++) {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+
+        workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++) {
+            workers.emplace_back(&BananJobSystem::workerLoop, this, i);
+        }
+    }
+
+    BananJobSystem::~BananJobSystem() {
+        {
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    void BananJobSystem::run(Job job, BananJobCounter *counter) {
+        if (counter != nullptr) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        push({std::move(job), counter});
+    }
+
+    void BananJobSystem::runAfter(BananJobCounter &dependency, Job job, BananJobCounter *counter) {
+        if (counter != nullptr) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{dependency.continuationMutex};
+            if (!dependency.isDone()) {
+                dependency.continuations.emplace_back(std::move(job), counter);
+                return;
+            }
+        }
+
+        push({std::move(job), counter});
+    }
+
+    void BananJobSystem::wait(BananJobCounter &counter) {
+        uint32_t queueIndex = currentQueue();
+        while (!counter.isDone()) {
+            if (!tryRunJob(queueIndex)) {
+                std::this_thread::yield();
+            }
+        }
+
+        // the last job drops the count while holding this, so once we get it nobody touches the counter anymore
+        std::lock_guard<std::mutex> lock{counter.continuationMutex};
+    }
+
+    void BananJobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &func) {
+        if (count == 0) {
+            return;
+        }
+
+        grainSize = std::max<size_t>(grainSize, 1);
+        if (count <= grainSize) {
+            func(0, count);
+            return;
+        }
+
+        BananJobCounter counter{};
+        for (size_t begin = 0; begin < count; begin += grainSize) {
+            size_t end = std::min(begin + grainSize, count);
+            run([&func, begin, end]() { func(begin, end); }, &counter);
+        }
+
+        wait(counter);
+    }
+
+    void BananJobSystem::workerLoop(uint32_t index) {
+        currentSystem = this;
+        currentWorker = index;
+
+        while (true) {
+            if (tryRunJob(index)) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{sleepMutex};
+            wakeCondition.wait(lock, [this]() { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    void BananJobSystem::push(PendingJob pendingJob) {
+        auto &queue = *queues[currentQueue()];
+        {
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            queue.jobs.push_back(std::move(pendingJob));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            queuedJobs.fetch_add(1, std::memory_order_release);
+        }
+        wakeCondition.notify_one();
+    }
+
+    bool BananJobSystem::tryRunJob(uint32_t queueIndex) {
+        PendingJob pendingJob{};
+        bool found = false;
+
+        // own queue from the back, newest work is the most likely to still be in cache
+        {
+            auto &queue = *queues[queueIndex];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if (!queue.jobs.empty()) {
+                pendingJob = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                found = true;
+            }
+        }
+
+        // then steal the oldest job from everyone else, starting next to us so thieves spread out
+        for (size_t offset = 1; !found && offset < queues.size(); offset++) {
+            auto &queue = *queues[(queueIndex + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if (!queue.jobs.empty()) {
+                pendingJob = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+                found = true;
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        pendingJob.job();
+        finish(pendingJob.counter);
+        return true;
+    }
+
+    uint32_t BananJobSystem::currentQueue() const {
+        return currentSystem == this ? currentWorker : static_cast<uint32_t>(workers.size());
+    }
+
+    void BananJobSystem::finish(BananJobCounter *counter) {
+        if (counter == nullptr) {
+            return;
+        }
+
+        std::vector<std::pair<Job, BananJobCounter *>> ready;
+        {
+            std::lock_guard<std::mutex> lock{counter->continuationMutex};
+            if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            ready.swap(counter->continuations);
+        }
+
+        for (auto &[job, jobCounter] : ready) {
+            push({std::move(job), jobCounter});
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Banan {
+    class BananJobSystem;
+
+    // counts the jobs still running for a group, jobs queued with runAfter start once it reaches zero.
+    // only destroy a counter after BananJobSystem::wait has returned for it
+    class BananJobCounter {
+    public:
+        BananJobCounter() = default;
+        BananJobCounter(const BananJobCounter &) = delete;
+        BananJobCounter &operator=(const BananJobCounter &) = delete;
+
+        bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        std::atomic<uint32_t> pending{0};
+        std::mutex continuationMutex;
+        std::vector<std::pair<std::function<void()>, BananJobCounter *>> continuations;
+
+        friend class BananJobSystem;
+    };
+
+    class BananJobSystem {
+    public:
+        using Job = std::function<void()>;
+
+        // one thread is left for the caller, which runs jobs itself whenever it waits
+        explicit BananJobSystem(uint32_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+        ~BananJobSystem();
+
+        BananJobSystem(const BananJobSystem &) = delete;
+        BananJobSystem &operator=(const BananJobSystem &) = delete;
+
+        void run(Job job, BananJobCounter *counter = nullptr);
+        // the job is only queued once dependency is done, counter tracks it from now on so it can be waited on straight away
+        void runAfter(BananJobCounter &dependency, Job job, BananJobCounter *counter = nullptr);
+
+        // runs other jobs while waiting, so calling this from inside a job never deadlocks the pool
+        void wait(BananJobCounter &counter);
+
+        // splits [0, count) into chunks of at most grainSize and blocks (helpfully) until they're all done
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)> &func);
+
+        uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+        // 0 to getWorkerCount() - 1 on the workers and getWorkerCount() on any thread outside the pool, stable for the
+        // lifetime of the thread so it can pick per-thread resources
+        uint32_t getThreadIndex() const { return currentQueue(); }
+
+    private:
+        struct PendingJob {
+            Job job;
+            BananJobCounter *counter;
+        };
+
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<PendingJob> jobs;
+        };
+
+        void workerLoop(uint32_t index);
+        void push(PendingJob pendingJob);
+        bool tryRunJob(uint32_t queueIndex);
+        uint32_t currentQueue() const;
+        void finish(BananJobCounter *counter);
+
+        // one deque per worker plus a shared one for every thread outside the pool
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::thread> workers;
+
+        std::atomic<uint32_t> queuedJobs{0};
+        std::atomic<bool> stopping{false};
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+    };
+}
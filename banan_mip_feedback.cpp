@@ -0,0 +1,52 @@
+#include "banan_mip_feedback.h"
+#include "banan_swap_chain.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Banan {
+
+    BananMipFeedback::BananMipFeedback(BananDevice &device, uint32_t textureCount) : bananDevice{device}, textureCount{textureCount}, pendingMipLevels(textureCount, MIP_NOT_SAMPLED), requiredMipLevels(textureCount, MIP_NOT_SAMPLED) {
+        feedbackBuffers.resize(BananSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &buffer : feedbackBuffers) {
+            buffer = std::make_unique<BananBuffer>(bananDevice, sizeof(uint32_t), textureCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            buffer->map();
+            reset(*buffer);
+        }
+    }
+
+    void BananMipFeedback::recordReadback(VkCommandBuffer commandBuffer) {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void BananMipFeedback::collect(int frameIndex) {
+        auto &buffer = *feedbackBuffers[frameIndex];
+        buffer.invalidate();
+
+        auto *mipLevels = static_cast<uint32_t *>(buffer.getMappedMemory());
+        for (uint32_t i = 0; i < textureCount; i++) {
+            pendingMipLevels[i] = std::min(pendingMipLevels[i], mipLevels[i]);
+        }
+        reset(buffer);
+
+        // every pixel has been covered once the pattern wraps around, so the table is exact for that window
+        if (++collectedFrames % (PATTERN_SIZE * PATTERN_SIZE) == 0) {
+            requiredMipLevels.swap(pendingMipLevels);
+            std::fill(pendingMipLevels.begin(), pendingMipLevels.end(), MIP_NOT_SAMPLED);
+        }
+    }
+
+    VkDescriptorBufferInfo BananMipFeedback::descriptorInfo(int frameIndex) {
+        return feedbackBuffers[frameIndex]->descriptorInfo();
+    }
+
+    void BananMipFeedback::reset(BananBuffer &buffer) {
+        memset(buffer.getMappedMemory(), 0xFF, buffer.getBufferSize());
+        buffer.flush();
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "banan_buffer.h"
+
+#include <memory>
+#include <vector>
+
+namespace Banan {
+    class BananMipFeedback {
+    public:
+        static constexpr uint32_t MIP_NOT_SAMPLED = 0xFFFFFFFF;
+        // shaders write one pixel out of every PATTERN_SIZE x PATTERN_SIZE block, rotating through the block each frame
+        static constexpr uint32_t PATTERN_SIZE = 4;
+
+        BananMipFeedback(BananDevice &device, uint32_t textureCount);
+
+        BananMipFeedback(const BananMipFeedback &) = delete;
+        BananMipFeedback &operator=(const BananMipFeedback &) = delete;
+
+        // makes the frame's shader writes visible to the host, record it after the last pass that writes feedback
+        void recordReadback(VkCommandBuffer commandBuffer);
+        // must be called after the frame's fence has signaled, i.e. after beginFrame returns
+        void collect(int frameIndex);
+
+        VkDescriptorBufferInfo descriptorInfo(int frameIndex);
+        uint32_t getTextureCount() const { return textureCount; }
+        uint32_t getRequiredMipLevel(uint32_t textureIndex) const { return requiredMipLevels[textureIndex]; }
+        const std::vector<uint32_t> &getRequiredMipLevels() const { return requiredMipLevels; }
+
+    private:
+        void reset(BananBuffer &buffer);
+
+        BananDevice &bananDevice;
+        uint32_t textureCount;
+        uint32_t collectedFrames = 0;
+
+        std::vector<std::unique_ptr<BananBuffer>> feedbackBuffers;
+        std::vector<uint32_t> pendingMipLevels;
+        std::vector<uint32_t> requiredMipLevels;
+    };
+}
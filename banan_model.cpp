@@ -8,6 +8,7 @@
 #include <cassert>
 #include <cstring>
 #include <iterator>
+#include <mutex>
 #include <thread>
 
 #include <assimp/Importer.hpp>
@@ -20,18 +21,75 @@
 
 #include <ImathBox.h>
 #include <ImfRgbaFile.h>
-#include <ImfArray.h>
+#include <ImfInputFile.h>
+#include <ImfFrameBuffer.h>
+#include <ImfChannelList.h>
+#include <ImfHeader.h>
 
 using namespace Imf;
 using namespace Imath;
 
 namespace Banan {
+    void BananModel::Texture::release() {
+        if (stagingBuffer == nullptr) {
+            free(data);
+        }
+
+        data = nullptr;
+        stagingBuffer.reset();
+    }
+
+    VkFormat BananModel::Texture::getFormat() const {
+        if (floatingPoint) {
+            switch (channels) {
+                case 1: return VK_FORMAT_R16_SFLOAT;
+                case 2: return VK_FORMAT_R16G16_SFLOAT;
+                default: return VK_FORMAT_R16G16B16A16_SFLOAT;
+            }
+        }
+
+        if (stride == 16) {
+            switch (channels) {
+                case 1: return VK_FORMAT_R16_UNORM;
+                case 2: return VK_FORMAT_R16G16_UNORM;
+                default: return VK_FORMAT_R16G16B16A16_UNORM;
+            }
+        }
+
+        switch (channels) {
+            case 1: return VK_FORMAT_R8_UNORM;
+            case 2: return VK_FORMAT_R8G8_UNORM;
+            default: return type == TextureType::ALBEDO ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        }
+    }
+
+    uint32_t BananModel::Texture::channelCount(TextureType type) {
+        switch (type) {
+            case TextureType::NORMAL: return 2;
+            case TextureType::HEIGHT:
+            case TextureType::MASK: return 1;
+            default: return 4;
+        }
+    }
+
+    const unsigned int BananModel::DEFAULT_POST_PROCESS_FLAGS = aiProcess_Triangulate |
+                                                               aiProcess_GenSmoothNormals |
+                                                               aiProcess_FlipUVs |
+                                                               aiProcess_JoinIdenticalVertices |
+                                                               aiProcess_GenUVCoords |
+                                                               aiProcess_CalcTangentSpace |
+                                                               aiProcess_MakeLeftHanded;
+
     BananModel::BananModel(BananDevice &device, const Builder &builder) : bananDevice{device} {
         createTextureImage(builder.texture);
         createNormalImage(builder.normals);
         createHeightmap(builder.heights);
         createVertexBuffers(builder.positions, builder.misc);
         createIndexBuffers(builder.indices);
+
+        for (const auto &position : builder.positions) {
+            bounds.expand(position);
+        }
     }
 
     BananModel::~BananModel() {
@@ -57,12 +115,30 @@ namespace Banan {
         }
     }
 
-    void BananModel::draw(VkCommandBuffer commandBuffer) {
+    void BananModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance) {
+
+        if (hasIndexBuffer) {
+            vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
+        } else {
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
+        }
+    }
 
+    BananModel::IndirectCommand BananModel::indirectCommand(uint32_t firstInstance) const {
+        IndirectCommand command{};
         if (hasIndexBuffer) {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            command.indexed = {indexCount, 0, 0, 0, firstInstance};
         } else {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            command.nonIndexed = {vertexCount, 0, 0, firstInstance};
+        }
+        return command;
+    }
+
+    void BananModel::drawIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) {
+        if (hasIndexBuffer) {
+            vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, 1, sizeof(IndirectCommand));
+        } else {
+            vkCmdDrawIndirect(commandBuffer, buffer, offset, 1, sizeof(IndirectCommand));
         }
     }
 
@@ -117,92 +193,83 @@ namespace Banan {
         return std::make_unique<BananModel>(device, builder);
     }
 
+    std::unique_ptr<BananImage> BananModel::createImageFromTexture(BananDevice &device, const Texture &texture) {
+        uint32_t pixelCount = texture.width * texture.height;
+        assert(pixelCount > 0 && "Failed to load image: 0 pixels");
+        auto pixelSize = static_cast<uint32_t>(texture.getPixelSize());
+        VkFormat format = texture.getFormat();
+
+        VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if (texture.mipLevels > 1) {
+            features |= VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+        }
+
+        // 16 bit unorm formats don't have to support filtering or blits, the half float formats of the same size do
+        Texture halfTexture = texture;
+        halfTexture.floatingPoint = true;
+        std::vector<VkFormat> candidates{format};
+        if (!texture.floatingPoint && texture.stride == 16) {
+            candidates.push_back(halfTexture.getFormat());
+        }
+
+        std::shared_ptr<BananBuffer> stagingBuffer = texture.stagingBuffer;
+        if (device.findSupportedFormat(candidates, VK_IMAGE_TILING_OPTIMAL, features) != format) {
+            format = halfTexture.getFormat();
+
+            stagingBuffer = std::make_shared<BananBuffer>(device, pixelSize, pixelCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            stagingBuffer->map();
+
+            const auto *source = static_cast<const uint16_t *>(texture.data);
+            auto *dest = static_cast<uint16_t *>(stagingBuffer->getMappedMemory());
+            size_t valueCount = static_cast<size_t>(pixelCount) * texture.channels;
+            for (size_t i = 0; i < valueCount; i++) {
+                dest[i] = half{static_cast<float>(source[i]) / 65535.0f}.bits();
+            }
+        } else if (stagingBuffer == nullptr) {
+            stagingBuffer = std::make_shared<BananBuffer>(device, pixelSize, pixelCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            stagingBuffer->map();
+            stagingBuffer->writeToBuffer(texture.data);
+        }
+
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+        auto image = std::make_unique<BananImage>(device, texture.width, texture.height, texture.mipLevels, format, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        device.endSingleTimeCommands(commandBuffer);
+        device.copyBufferToImage(stagingBuffer->getBuffer(), image->getImageHandle(), texture.width, texture.height, 1);
+        image->generateMipMaps(texture.mipLevels);
+
+        return image;
+    }
+
     void BananModel::createTextureImage(const Texture &image) {
-        if (image.width > 0 && image.height > 0) {
-            texturepixelCount = image.width * image.height;
-            assert(texturepixelCount >= 0 && "Failed to load image: 0 pixels");
-            uint32_t pixelSize = image.stride / 2; // stride is in bits, pixel size should be in bytes
-
-            VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
-            if (image.stride == 16) format = VK_FORMAT_R16G16B16A16_SFLOAT;
-
-            BananBuffer stagingBuffer{bananDevice, pixelSize, texturepixelCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
-            stagingBuffer.map();
-            stagingBuffer.writeToBuffer((void *)image.data);
-
-            VkCommandBuffer commandBuffer = bananDevice.beginSingleTimeCommands();
-            textureImage = std::make_unique<BananImage>(bananDevice, image.width, image.height, image.mipLevels, format, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-            textureImage->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-            bananDevice.endSingleTimeCommands(commandBuffer);
-            bananDevice.copyBufferToImage(stagingBuffer.getBuffer(), textureImage->getImageHandle(), image.width, image.height, 1);
-            textureImage->generateMipMaps(image.mipLevels);
-
-            hasTexture = true;
-        } else {
-            hasTexture = false;
+        hasTexture = image.width > 0 && image.height > 0;
+        if (hasTexture) {
+            textureImage = createImageFromTexture(bananDevice, image);
         }
 
-        if (image.data != nullptr) {
+        if (image.stagingBuffer == nullptr) {
             free(image.data);
         }
     }
 
     void BananModel::createNormalImage(const Texture &image) {
-        if (image.height > 0 && image.width > 0) {
-            normalpixelCount = image.height * image.width;
-            assert(normalpixelCount >= 0 && "Failed to load image: 0 pixels");
-            uint32_t pixelSize = image.stride / 2; // stride is in bits, pixel size should be in bytes
-
-            VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
-            if (image.stride == 16) format = VK_FORMAT_R16G16B16A16_SFLOAT;
-
-            BananBuffer stagingBuffer{bananDevice, pixelSize, normalpixelCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
-            stagingBuffer.map();
-            stagingBuffer.writeToBuffer((void *)image.data);
-
-            VkCommandBuffer commandBuffer = bananDevice.beginSingleTimeCommands();
-            normalImage = std::make_unique<BananImage>(bananDevice, image.width, image.height, image.mipLevels, format, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-            normalImage->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-            bananDevice.endSingleTimeCommands(commandBuffer);
-            bananDevice.copyBufferToImage(stagingBuffer.getBuffer(), normalImage->getImageHandle(), image.width, image.height, 1);
-            bananDevice.generateMipMaps(normalImage->getImageHandle(), image.width, image.height, image.mipLevels);
-
-            hasNormal = true;
-        } else {
-            hasNormal = false;
+        hasNormal = image.width > 0 && image.height > 0;
+        if (hasNormal) {
+            normalImage = createImageFromTexture(bananDevice, image);
         }
 
-        if (image.data != nullptr) {
+        if (image.stagingBuffer == nullptr) {
             free(image.data);
         }
     }
 
     void BananModel::createHeightmap(const Texture &image) {
-        if (image.height > 0 && image.width > 0) {
-            heightMapPixelCount = image.height * image.width;
-            assert(heightMapPixelCount >= 0 && "Failed to load image: 0 pixels");
-            uint32_t pixelSize = image.stride / 2; // stride is in bits, pixel size should be in bytes
-
-            VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
-            if (image.stride == 16) format = VK_FORMAT_R16G16B16A16_SFLOAT;
-
-            BananBuffer stagingBuffer{bananDevice, pixelSize, heightMapPixelCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
-            stagingBuffer.map();
-            stagingBuffer.writeToBuffer((void *)image.data);
-
-            VkCommandBuffer commandBuffer = bananDevice.beginSingleTimeCommands();
-            heightMap = std::make_unique<BananImage>(bananDevice, image.width, image.height, image.mipLevels, format, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-            heightMap->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-            bananDevice.endSingleTimeCommands(commandBuffer);
-            bananDevice.copyBufferToImage(stagingBuffer.getBuffer(), heightMap->getImageHandle(), image.width, image.height, 1);
-            bananDevice.generateMipMaps(heightMap->getImageHandle(), image.width, image.height, image.mipLevels);
-
-            hasHeightmap = true;
-        } else {
-            hasHeightmap = false;
+        hasHeightmap = image.width > 0 && image.height > 0;
+        if (hasHeightmap) {
+            heightMap = createImageFromTexture(bananDevice, image);
         }
 
-        if (image.data != nullptr) {
+        if (image.stagingBuffer == nullptr) {
             free(image.data);
         }
     }
@@ -216,7 +283,7 @@ namespace Banan {
     }
 
     bool BananModel::isHeightmapLoaded() {
-        return hasHeightmap && normalImage != nullptr;
+        return hasHeightmap && heightMap != nullptr;
     }
 
     VkDescriptorImageInfo BananModel::getDescriptorTextureImageInfo() {
@@ -269,16 +336,19 @@ namespace Banan {
         return attributeDescriptions;
     }
 
-    void BananModel::Builder::loadModel(const std::string &filepath) {
+    std::vector<VkVertexInputAttributeDescription> BananModel::Vertex::getParallaxAttributeDescriptions() {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0});
+        attributeDescriptions.push_back({2, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)});
+        attributeDescriptions.push_back({4, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)});
+
+        return attributeDescriptions;
+    }
+
+    void BananModel::Builder::loadModel(const std::string &filepath, unsigned int postProcessFlags) {
         Assimp::Importer importer;
-        const aiScene *scene = importer.ReadFile(filepath,
-                                                 aiProcess_Triangulate |
-                                                 aiProcess_GenSmoothNormals |
-                                                 aiProcess_FlipUVs |
-                                                 aiProcess_JoinIdenticalVertices |
-                                                 aiProcess_GenUVCoords |
-                                                 aiProcess_CalcTangentSpace |
-                                                 aiProcess_MakeLeftHanded);
+        const aiScene *scene = importer.ReadFile(filepath, postProcessFlags);
 
         positions.clear();
         misc.clear();
@@ -387,52 +457,21 @@ namespace Banan {
     }
 
     void BananModel::Builder::loadTexture(const std::string &filepath) {
-        char *fileName = const_cast<char *>(filepath.c_str());
-        size_t len = strlen(fileName);
-        size_t idx = len-1;
-        for(size_t i = 0; *(fileName+i); i++) {
-            if (*(fileName+i) == '.') {
-                idx = i;
-            } else if (*(fileName + i) == '/' || *(fileName + i) == '\\') {
-                idx = len - 1;
-            }
-        }
-
-        std::string extension = std::string(fileName).substr(idx+1);
-
-        if (extension == "exr") {
-            loadHDR(filepath, texture);
-        } else if (extension == "jpg" || extension == "jpeg" || extension == "png") {
-            loadRGB(filepath, texture);
-        } else {
-            throw std::runtime_error("unsupported texture file format");
-        }
+        loadImage(filepath, texture);
     }
 
     void BananModel::Builder::loadNormals(const std::string &filepath) {
-        char *fileName = const_cast<char *>(filepath.c_str());
-        size_t len = strlen(fileName);
-        size_t idx = len-1;
-        for(size_t i = 0; *(fileName+i); i++) {
-            if (*(fileName+i) == '.') {
-                idx = i;
-            } else if (*(fileName + i) == '/' || *(fileName + i) == '\\') {
-                idx = len - 1;
-            }
-        }
-
-        std::string extension = std::string(fileName).substr(idx+1);
-
-        if (extension == "exr") {
-            loadHDR(filepath, normals);
-        } else if (extension == "jpg" || extension == "jpeg" || extension == "png") {
-            loadRGB(filepath, normals);
-        } else {
-            throw std::runtime_error("unsupported texture file format");
-        }
+        loadImage(filepath, normals, TextureType::NORMAL);
     }
 
     void BananModel::Builder::loadHeightMap(const std::string &filepath) {
+        loadImage(filepath, heights, TextureType::HEIGHT);
+    }
+
+    void BananModel::Builder::loadImage(const std::string &filepath, Texture &target, TextureType type) {
+        target.type = type;
+        target.channels = Texture::channelCount(type);
+
         char *fileName = const_cast<char *>(filepath.c_str());
         size_t len = strlen(fileName);
         size_t idx = len-1;
@@ -447,61 +486,102 @@ namespace Banan {
         std::string extension = std::string(fileName).substr(idx+1);
 
         if (extension == "exr") {
-            loadHDR(filepath, heights);
+            loadHDR(filepath, target);
         } else if (extension == "jpg" || extension == "jpeg" || extension == "png") {
-            loadRGB(filepath, heights);
+            loadRGB(filepath, target);
         } else {
             throw std::runtime_error("unsupported texture file format");
         }
     }
 
     void BananModel::Builder::loadHDR(const string &filepath, Texture &target) {
-        Imf::setGlobalThreadCount((int) std::thread::hardware_concurrency());
-        Imf::Array2D<Rgba> pixelBuffer = Imf::Array2D<Rgba>();
-        Imf::Array2D<Rgba> &pixelBufferRef = pixelBuffer;
+        static std::once_flag threadCountFlag;
+        std::call_once(threadCountFlag, [] { Imf::setGlobalThreadCount((int) std::thread::hardware_concurrency()); });
+
+        // interleaved halfs are the exact layout of the R16/RG16/RGBA16 float formats, so OpenEXR decodes straight into the upload memory
+        auto allocate = [this, &target](const Imath::Box2i &win) {
+            target.width = static_cast<uint32_t>(win.max.x - win.min.x + 1);
+            target.height = static_cast<uint32_t>(win.max.y - win.min.y + 1);
+            target.stride = 16;
+            target.floatingPoint = true;
+            target.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(target.width, target.height)))) + 1;
+
+            size_t pixelSize = target.getPixelSize();
+            size_t pixelCount = static_cast<size_t>(target.width) * target.height;
+            if (stagingDevice != nullptr) {
+                target.stagingBuffer = std::make_shared<BananBuffer>(*stagingDevice, pixelSize, pixelCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                target.stagingBuffer->map();
+                target.data = target.stagingBuffer->getMappedMemory();
+            } else {
+                target.data = malloc(pixelCount * pixelSize);
+            }
 
-        Imf::RgbaInputFile in(filepath.c_str());
-        Imath::Box2i win = in.dataWindow();
-        Imath::V2i dim(win.max.x - win.min.x + 1, win.max.y - win.min.y + 1);
+            // offset so the data window's origin lands on the first pixel
+            return static_cast<char *>(target.data) - (win.min.x + static_cast<ptrdiff_t>(win.min.y) * target.width) * pixelSize;
+        };
 
-        int dx = win.min.x;
-        int dy = win.min.y;
+        if (target.channels == 4) {
+            // the rgba interface also converts luminance/chroma files
+            Imf::RgbaInputFile in(filepath.c_str());
+            Imath::Box2i win = in.dataWindow();
 
-        pixelBufferRef.resizeErase(dim.x, dim.y);
+            auto *base = reinterpret_cast<Imf::Rgba *>(allocate(win));
+            in.setFrameBuffer(base, 1, target.width);
+            in.readPixels(win.min.y, win.max.y);
+            return;
+        }
 
-        in.setFrameBuffer(&pixelBufferRef[0][0] - dx - dy * dim.x, 1, dim.x);
-        in.readPixels(win.min.y, win.max.y);
+        Imf::InputFile in(filepath.c_str());
+        Imath::Box2i win = in.header().dataWindow();
+        char *base = allocate(win);
 
-        target.data = (uint16_t *) malloc(dim.y * dim.y * 8);
-        target.width = dim.x;
-        target.height = dim.y;
-        target.stride = 16;
-        target.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(target.width, target.width)))) + 1;
-
-        auto *singleChannelPixelBuffer = (uint16_t *) malloc(dim.y * dim.y * 8);
-        int index = 0;
-
-        for (int y1 = 0; y1 < dim.y; y1++) {
-            for (int x1 = 0; x1 < dim.x; x1++) {
-                singleChannelPixelBuffer[index++] = pixelBufferRef[y1][x1].r.bits();
-                singleChannelPixelBuffer[index++] = pixelBufferRef[y1][x1].g.bits();
-                singleChannelPixelBuffer[index++] = pixelBufferRef[y1][x1].b.bits();
-                singleChannelPixelBuffer[index++] = pixelBufferRef[y1][x1].a.bits();
-            }
+        // single channel maps are often stored as luminance
+        const char *channelNames[] = {"R", "G"};
+        if (in.header().channels().findChannel("R") == nullptr && in.header().channels().findChannel("Y") != nullptr) {
+            channelNames[0] = "Y";
+        }
+
+        size_t pixelSize = target.getPixelSize();
+        Imf::FrameBuffer frameBuffer;
+        for (uint32_t c = 0; c < target.channels; c++) {
+            frameBuffer.insert(channelNames[c], Imf::Slice(Imf::HALF, base + c * sizeof(half), pixelSize, pixelSize * target.width, 1, 1, 0.0));
         }
 
-        memcpy(target.data, singleChannelPixelBuffer, dim.x * dim.y * 8);
-        free(singleChannelPixelBuffer);
+        in.setFrameBuffer(frameBuffer);
+        in.readPixels(win.min.y, win.max.y);
     }
 
     void BananModel::Builder::loadRGB(const string &filepath, Texture &target) {
-        uint8_t *data = stbi_load(filepath.c_str(), (int *) &target.width, (int *) &target.height, nullptr, STBI_rgb_alpha);
+        int width = 0;
+        int height = 0;
 
-        target.data = (uint8_t *) malloc(target.width * target.height * 4);
-        target.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(target.width, target.width)))) + 1;
-        target.stride = 8;
+        // normals keep their rgb so the red and green channels can be packed below, stb would turn 2 channels into grey + alpha
+        int requestedChannels = target.channels == 2 ? STBI_rgb : static_cast<int>(target.channels);
+        bool sixteenBit = target.type != TextureType::ALBEDO && stbi_is_16_bit(filepath.c_str());
 
-        memcpy(target.data, data, target.width * target.height * 4);
-        stbi_image_free(data);
+        if (sixteenBit) {
+            target.data = stbi_load_16(filepath.c_str(), &width, &height, nullptr, requestedChannels);
+            target.stride = 16;
+        } else {
+            target.data = stbi_load(filepath.c_str(), &width, &height, nullptr, requestedChannels);
+            target.stride = 8;
+        }
+
+        if (target.data == nullptr) {
+            throw std::runtime_error("failed to load texture: " + filepath);
+        }
+
+        target.width = static_cast<uint32_t>(width);
+        target.height = static_cast<uint32_t>(height);
+        target.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(target.width, target.height)))) + 1;
+
+        if (target.channels == 2) {
+            size_t pixelCount = static_cast<size_t>(width) * height;
+            size_t channelSize = target.stride / 8;
+            auto *pixels = static_cast<uint8_t *>(target.data);
+            for (size_t i = 0; i < pixelCount; i++) {
+                memmove(pixels + i * 2 * channelSize, pixels + i * 3 * channelSize, 2 * channelSize);
+            }
+        }
     }
 }
\ No newline at end of file
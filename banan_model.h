@@ -7,6 +7,7 @@
 #include "banan_device.h"
 #include "banan_buffer.h"
 #include "banan_image.h"
+#include "banan_bounds.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -18,12 +19,33 @@
 namespace Banan {
     class BananModel {
     public:
+        static const unsigned int DEFAULT_POST_PROCESS_FLAGS;
+
+        enum class TextureType {
+            ALBEDO, // rgba, srgb
+            NORMAL, // rg, z is reconstructed in the shader
+            HEIGHT, // r
+            MASK // r
+        };
+
         struct Texture {
             void *data = nullptr;
-            size_t stride = 0;
+            size_t stride = 0; // bits per channel
             uint32_t width = 0;
             uint32_t height = 0;
             uint32_t mipLevels = 1;
+            uint32_t channels = 4;
+            bool floatingPoint = false;
+            TextureType type = TextureType::ALBEDO;
+
+            // when set, data points into this buffer's mapped memory and is uploaded without another copy
+            std::shared_ptr<BananBuffer> stagingBuffer;
+
+            void release();
+            VkFormat getFormat() const;
+            size_t getPixelSize() const { return stride * channels / 8; }
+
+            static uint32_t channelCount(TextureType type);
         };
 
         struct Vertex {
@@ -36,6 +58,8 @@ namespace Banan {
             static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
             static std::vector<VkVertexInputBindingDescription> getPositionOnlyBindingDescriptions();
             static std::vector<VkVertexInputAttributeDescription> getPositionOnlyAttributeDescriptions();
+            // position, normal and uv at the same locations as the full set, for passes that only need the parallax uv
+            static std::vector<VkVertexInputAttributeDescription> getParallaxAttributeDescriptions();
         };
 
         struct Builder {
@@ -47,11 +71,16 @@ namespace Banan {
             Texture normals{};
             Texture heights{};
 
-            void loadModel(const std::string &filepath);
+            // lets loaders that can decode into their final layout write straight into a staging buffer
+            BananDevice *stagingDevice = nullptr;
+
+            void loadModel(const std::string &filepath, unsigned int postProcessFlags = DEFAULT_POST_PROCESS_FLAGS);
             void loadTexture(const std::string &filepath);
             void loadNormals(const std::string &filepath);
             void loadHeightMap(const std::string &filepath);
 
+            void loadImage(const std::string &filepath, Texture &target, TextureType type = TextureType::ALBEDO);
+
             void loadHDR(const std::string &filepath, Texture &target);
             void loadRGB(const std::string &filepath, Texture &target);
         };
@@ -63,15 +92,29 @@ namespace Banan {
         BananModel &operator=(const BananModel &) = delete;
 
         static std::unique_ptr<BananModel> createModelFromFile(BananDevice &device, const std::string &filepath);
+        static std::unique_ptr<BananImage> createImageFromTexture(BananDevice &device, const Texture &texture);
 
         void bindPosition(VkCommandBuffer commandBuffer);
         void bindAll(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer);
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+        // indexed and non indexed commands share one stride so instanceCount is always the second uint, whatever the model
+        union IndirectCommand {
+            VkDrawIndexedIndirectCommand indexed;
+            VkDrawIndirectCommand nonIndexed;
+        };
+
+        // a command drawing the whole model with no instances yet, for a shader to count them in
+        IndirectCommand indirectCommand(uint32_t firstInstance) const;
+        void drawIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset);
 
         bool isTextureLoaded();
         bool isNormalsLoaded();
         bool isHeightmapLoaded();
 
+        // model space box around every vertex
+        const BananAABB &getBounds() const { return bounds; }
+
         VkDescriptorImageInfo getDescriptorTextureImageInfo();
         VkDescriptorImageInfo getDescriptorNormalImageInfo();
         VkDescriptorImageInfo getDescriptorHeightMapInfo();
@@ -89,6 +132,7 @@ namespace Banan {
         bool hasHeightmap;
 
         BananDevice &bananDevice;
+        BananAABB bounds{};
 
         std::unique_ptr<BananBuffer> vertexBuffer;
         std::unique_ptr<BananBuffer> miscBuffer;
@@ -98,12 +142,7 @@ namespace Banan {
         uint32_t indexCount;
 
         std::unique_ptr<BananImage> textureImage;
-        uint32_t texturepixelCount;
-
         std::unique_ptr<BananImage> normalImage;
-        uint32_t normalpixelCount;
-
         std::unique_ptr<BananImage> heightMap;
-        uint32_t heightMapPixelCount;
     };
 }
\ No newline at end of file
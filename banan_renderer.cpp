@@ -8,7 +8,7 @@
 #include <array>
 
 namespace Banan {
-    BananRenderer::BananRenderer(BananWindow &window, BananDevice &device) : bananWindow{window}, bananDevice{device} {
+    BananRenderer::BananRenderer(BananWindow &window, BananDevice &device, uint32_t recordingThreads) : bananWindow{window}, bananDevice{device}, commandRecorder{device, BananSwapChain::MAX_FRAMES_IN_FLIGHT, recordingThreads} {
         recreateSwapChain();
         createCommandBuffers();
     }
@@ -72,7 +72,7 @@ namespace Banan {
             SDL_WaitEvent(&event);
         }
 
-        vkDeviceWaitIdle(bananDevice.device());
+        bananDevice.waitIdle();
         if (bananSwapChain == nullptr) {
             bananSwapChain = std::make_unique<BananSwapChain>(bananDevice, extent, nullptr);
         } else {
@@ -100,6 +100,9 @@ namespace Banan {
 
         isFrameStarted = true;
 
+        // the fence acquireNextImage waited on covers the secondary buffers this frame index recorded last time too
+        commandRecorder.reset(currentFrameIndex);
+
         auto commandBuffer = getCurrentCommandBuffer();
 
         VkCommandBufferBeginInfo beginInfo{};
@@ -136,15 +139,25 @@ namespace Banan {
         assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on command buffer that is different to the current frame");
 
         vkCmdEndRenderPass(commandBuffer);
+        currentRenderPass = VK_NULL_HANDLE;
+        currentFramebuffer = VK_NULL_HANDLE;
+    }
+
+    void BananRenderer::beginEarlyGeometryRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+        beginGeometryRenderPass(commandBuffer, bananSwapChain->getEarlyGeometryRenderpass(), contents);
+    }
+
+    void BananRenderer::beginGeometryRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+        beginGeometryRenderPass(commandBuffer, bananSwapChain->getGeometryRenderpass(), contents);
     }
 
-    void BananRenderer::beginGeometryRenderPass(VkCommandBuffer commandBuffer) {
+    void BananRenderer::beginGeometryRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkSubpassContents contents) {
         assert(isFrameStarted && "Cant begin render pass if frame is not in progress");
         assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer that is different to the current frame");
 
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = bananSwapChain->getGeometryRenderpass();
+        renderPassInfo.renderPass = renderPass;
         renderPassInfo.framebuffer = bananSwapChain->getGeometryFramebuffer();
 
         renderPassInfo.renderArea.offset = {0, 0};
@@ -159,8 +172,39 @@ namespace Banan {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        // set before the pass begins, a subpass recorded from secondary command buffers can't take any other command
+        setViewportAndScissor(commandBuffer);
+
+        currentRenderPass = renderPassInfo.renderPass;
+        currentFramebuffer = renderPassInfo.framebuffer;
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+    }
+
+    VkCommandBuffer BananRenderer::beginSecondaryCommandBuffer(uint32_t threadIndex, uint32_t subpass) {
+        return beginSecondaryCommandBuffer(commandRecorder, threadIndex, subpass);
+    }
 
+    VkCommandBuffer BananRenderer::beginSecondaryCommandBuffer(BananCommandRecorder &recorder, uint32_t threadIndex, uint32_t subpass) {
+        assert(isFrameStarted && "Cant begin secondary command buffer if frame is not in progress");
+        assert(currentRenderPass != VK_NULL_HANDLE && "Secondary command buffers continue a render pass, begin one first");
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = currentRenderPass;
+        inheritanceInfo.subpass = subpass;
+        inheritanceInfo.framebuffer = currentFramebuffer;
+
+        // dynamic state isn't inherited from the primary
+        VkCommandBuffer commandBuffer = recorder.begin(currentFrameIndex, threadIndex, inheritanceInfo);
+        setViewportAndScissor(commandBuffer);
+        return commandBuffer;
+    }
+
+    void BananRenderer::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer) {
+        commandRecorder.end(commandBuffer);
+    }
+
+    void BananRenderer::setViewportAndScissor(VkCommandBuffer commandBuffer) {
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
@@ -297,4 +341,8 @@ namespace Banan {
     VkDescriptorImageInfo BananRenderer::getBlendWeightDescriptorInfo() {
         return bananSwapChain->blend()->descriptorInfo();
     }
+
+    BananDepthPyramid &BananRenderer::getDepthPyramid() {
+        return *bananSwapChain->depthPyramid();
+    }
 }
\ No newline at end of file
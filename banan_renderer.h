@@ -8,6 +8,7 @@
 #include "banan_swap_chain.h"
 #include "banan_device.h"
 #include "banan_model.h"
+#include "banan_command_recorder.h"
 
 #include <memory>
 #include <vector>
@@ -19,7 +20,8 @@ namespace Banan{
         BananRenderer(const BananRenderer &) = delete;
         BananRenderer &operator=(const BananRenderer &) = delete;
 
-        BananRenderer(BananWindow &window, BananDevice &device);
+        // recordingThreads is how many threads may record secondary command buffers at once, indices 0 to recordingThreads - 1
+        BananRenderer(BananWindow &window, BananDevice &device, uint32_t recordingThreads = 1);
         ~BananRenderer();
 
         VkRenderPass getGeometryRenderPass() const;
@@ -37,19 +39,34 @@ namespace Banan{
         VkDescriptorImageInfo getGeometryDescriptorInfo();
         VkDescriptorImageInfo getEdgeDescriptorInfo();
         VkDescriptorImageInfo getBlendWeightDescriptorInfo();
+        // rebuilt with the swap chain, descriptors pointing at it have to be rewritten after a resize
+        BananDepthPyramid &getDepthPyramid();
 
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginGeometryRenderPass(VkCommandBuffer commandBuffer);
+        // the early pass draws what was visible last frame into a fresh g-buffer, the geometry pass adds the rest
+        // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the g-buffer subpass is filled by vkCmdExecuteCommands
+        void beginEarlyGeometryRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+        void beginGeometryRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void beginEdgeDetectionRenderPass(VkCommandBuffer commandBuffer);
         void beginBlendWeightRenderPass(VkCommandBuffer commandBuffer);
         void beginResolveRenderPass(VkCommandBuffer commandBuffer);
 
         void endRenderPass(VkCommandBuffer commandBuffer);
 
+        // a secondary command buffer continuing the render pass in progress at the given subpass, with the viewport and
+        // scissor already set. safe to call from any thread as long as no two threads share a threadIndex, the buffer is only
+        // valid until this frame index comes around again
+        VkCommandBuffer beginSecondaryCommandBuffer(uint32_t threadIndex, uint32_t subpass);
+        // same, but from a recorder the caller resets itself, for buffers that are kept and executed again in later frames
+        VkCommandBuffer beginSecondaryCommandBuffer(BananCommandRecorder &recorder, uint32_t threadIndex, uint32_t subpass);
+        void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+
         void recreateSwapChain();
 
     private:
+        void beginGeometryRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkSubpassContents contents);
+        void setViewportAndScissor(VkCommandBuffer commandBuffer);
         void createCommandBuffers();
         void freeCommandBuffers();
 
@@ -58,6 +75,11 @@ namespace Banan{
         std::unique_ptr<BananSwapChain> bananSwapChain;
         std::vector<VkCommandBuffer> commandBuffers{};
         std::vector<VkDescriptorImageInfo> GBufferInfo{};
+        BananCommandRecorder commandRecorder;
+
+        // what secondary command buffers inherit
+        VkRenderPass currentRenderPass{VK_NULL_HANDLE};
+        VkFramebuffer currentFramebuffer{VK_NULL_HANDLE};
 
         uint32_t currentImageIndex;
         int currentFrameIndex{0};
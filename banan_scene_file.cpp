@@ -0,0 +1,360 @@
+#include "banan_scene_file.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Banan {
+    static_assert(std::endian::native == std::endian::little, "scene files are stored little endian and read in place");
+    static_assert(sizeof(SceneFileHeader) == 40, "scene file header layout changed");
+    static_assert(sizeof(SceneObjectRecord) == 108, "scene object record layout changed, bump BananSceneFile::VERSION");
+
+    static constexpr char SCENE_MAGIC[4] = {'B', 'S', 'C', 'N'};
+
+    // the whole file mapped into memory, writable mappings write straight back to the file
+    class MappedFile {
+    public:
+        MappedFile(const std::string &filepath, bool writable) {
+#ifdef _WIN32
+            file = CreateFileA(filepath.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                return;
+            }
+
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+                return;
+            }
+
+            mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+            if (mapping == nullptr) {
+                return;
+            }
+
+            data = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+            size = data != nullptr ? static_cast<size_t>(fileSize.QuadPart) : 0;
+#else
+            int fd = open(filepath.c_str(), writable ? O_RDWR : O_RDONLY);
+            if (fd < 0) {
+                return;
+            }
+
+            struct stat fileStat{};
+            if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+                void *mapped = mmap(nullptr, fileStat.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+                if (mapped != MAP_FAILED) {
+                    data = mapped;
+                    size = static_cast<size_t>(fileStat.st_size);
+                }
+            }
+
+            // the mapping keeps the file alive on its own
+            close(fd);
+#endif
+        }
+
+        ~MappedFile() {
+#ifdef _WIN32
+            if (data != nullptr) UnmapViewOfFile(data);
+            if (mapping != nullptr) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+            if (data != nullptr) munmap(data, size);
+#endif
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        void flush() {
+#ifdef _WIN32
+            FlushViewOfFile(data, 0);
+#else
+            msync(data, size, MS_SYNC);
+#endif
+        }
+
+        uint8_t *bytes() const { return static_cast<uint8_t *>(data); }
+        size_t getSize() const { return size; }
+        bool isOpen() const { return data != nullptr; }
+
+    private:
+        void *data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+    };
+
+    BananSceneFile::BananSceneFile(std::string filepath) : filepath{std::move(filepath)} {
+    }
+
+    std::vector<BananGameObject::id_t> BananSceneFile::load(BananGameObjectManager &manager, BananAssetCache &assetCache, BananJobSystem &jobSystem) {
+        MappedFile file{filepath, false};
+        if (!file.isOpen() || file.getSize() < sizeof(SceneFileHeader)) {
+            throw std::runtime_error("failed to open scene: " + filepath);
+        }
+
+        SceneFileHeader header;
+        memcpy(&header, file.bytes(), sizeof(header));
+
+        // the ranges are checked against what's left after their offset, sums of header fields could wrap on a corrupt file
+        uint64_t recordsSize = static_cast<uint64_t>(header.objectCount) * sizeof(SceneObjectRecord);
+        if (memcmp(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0 || header.version != VERSION || header.recordSize != sizeof(SceneObjectRecord) ||
+            header.stringsOffset > file.getSize() || header.stringsSize > file.getSize() - header.stringsOffset ||
+            header.recordsOffset > file.getSize() || recordsSize > file.getSize() - header.recordsOffset || header.recordsOffset % alignof(SceneObjectRecord) != 0) {
+            throw std::runtime_error("failed to load scene, invalid header: " + filepath);
+        }
+
+        const char *strings = reinterpret_cast<const char *>(file.bytes() + header.stringsOffset);
+        const auto *records = reinterpret_cast<const SceneObjectRecord *>(file.bytes() + header.recordsOffset);
+
+        auto getString = [&](uint32_t offset) -> std::string {
+            if (offset >= header.stringsSize || memchr(strings + offset, '\0', header.stringsSize - offset) == nullptr) {
+                throw std::runtime_error("failed to load scene, invalid string reference: " + filepath);
+            }
+            return std::string{strings + offset};
+        };
+
+        // every asset is resolved up front so the cache can decode them all at once
+        std::vector<std::string> modelPaths;
+        std::vector<std::pair<std::string, TextureImportSettings>> texturePaths;
+        for (uint32_t i = 0; i < header.objectCount; i++) {
+            const SceneObjectRecord &record = records[i];
+            if (record.flags & SceneObjectRecord::HAS_MODEL) {
+                modelPaths.push_back(getString(record.model));
+            }
+
+            if (record.flags & SceneObjectRecord::HAS_MATERIAL) {
+                if (record.texture != SceneObjectRecord::NONE) texturePaths.push_back({getString(record.texture), {BananModel::TextureType::ALBEDO, true, true}});
+                if (record.normal != SceneObjectRecord::NONE) texturePaths.push_back({getString(record.normal), {BananModel::TextureType::NORMAL, true, true}});
+                if (record.height != SceneObjectRecord::NONE) texturePaths.push_back({getString(record.height), {BananModel::TextureType::HEIGHT, true, true}});
+            }
+        }
+
+        assetCache.preload(jobSystem, modelPaths, texturePaths);
+
+        std::vector<BananGameObject::id_t> ids;
+        ids.reserve(header.objectCount);
+        for (uint32_t i = 0; i < header.objectCount; i++) {
+            const SceneObjectRecord &record = records[i];
+            BananGameObject obj = manager.createGameObject();
+
+            auto &transform = obj.transform();
+            transform.translation = {record.translation[0], record.translation[1], record.translation[2]};
+            transform.rotation = {record.rotation[0], record.rotation[1], record.rotation[2]};
+            transform.scale = {record.scale[0], record.scale[1], record.scale[2]};
+
+            if (record.flags & SceneObjectRecord::HAS_MODEL) {
+                obj.add<ModelComponent>({assetCache.loadModel(getString(record.model))});
+            }
+
+            if (record.flags & SceneObjectRecord::HAS_MATERIAL) {
+                // atlas layouts aren't stable between runs, the transforms come from wherever the cache packed the maps this time
+                auto &material = obj.add<MaterialComponent>();
+                material.uvTransform = {record.uvTransform[0], record.uvTransform[1], record.uvTransform[2], record.uvTransform[3]};
+                if (record.texture != SceneObjectRecord::NONE) {
+                    BananAtlasRegion region = assetCache.loadTextureRegion(getString(record.texture), {BananModel::TextureType::ALBEDO, true, true});
+                    material.texture = region.page;
+                    material.uvTransform = region.uvTransform;
+                }
+                if (record.normal != SceneObjectRecord::NONE) {
+                    BananAtlasRegion region = assetCache.loadTextureRegion(getString(record.normal), {BananModel::TextureType::NORMAL, true, true});
+                    material.normal = region.page;
+                    material.normalUvTransform = region.uvTransform;
+                }
+                if (record.height != SceneObjectRecord::NONE) {
+                    BananAtlasRegion region = assetCache.loadTextureRegion(getString(record.height), {BananModel::TextureType::HEIGHT, true, true});
+                    material.height = region.page;
+                    material.heightUvTransform = region.uvTransform;
+                }
+            }
+
+            if (record.flags & SceneObjectRecord::HAS_PARALLAX) {
+                obj.add<ParallaxComponent>({record.heightscale, record.parallaxBias, record.numLayers, record.parallaxmode});
+            }
+
+            if (record.flags & SceneObjectRecord::IS_POINT_LIGHT) {
+                obj.add<PointLightComponent>({record.lightIntensity, {record.lightColor[0], record.lightColor[1], record.lightColor[2]}});
+            }
+
+            ids.push_back(obj.getId());
+        }
+
+        // parents can come after their children in the file, so links are made once every object exists
+        for (uint32_t i = 0; i < header.objectCount; i++) {
+            uint32_t parent = records[i].parent;
+            if (parent == SceneObjectRecord::NONE) continue;
+
+            if (parent >= header.objectCount) {
+                throw std::runtime_error("failed to load scene, invalid parent reference: " + filepath);
+            }
+            manager.setParent(ids[i], ids[parent]);
+        }
+
+        return ids;
+    }
+
+    size_t BananSceneFile::save(BananGameObjectManager &manager, const BananAssetCache &assetCache) {
+        std::vector<BananGameObject::id_t> ids = manager.pool<TransformComponent>().ids();
+        std::sort(ids.begin(), ids.end());
+
+        std::vector<uint32_t> recordIndices(manager.size(), SceneObjectRecord::NONE);
+        for (size_t i = 0; i < ids.size(); i++) {
+            recordIndices[ids[i]] = static_cast<uint32_t>(i);
+        }
+
+        std::string strings;
+        std::unordered_map<std::string, uint32_t> stringOffsets;
+        auto addString = [&](const void *asset, const glm::vec4 &uvTransform = glm::vec4{1.f, 1.f, 0.f, 0.f}) -> uint32_t {
+            if (asset == nullptr) {
+                return SceneObjectRecord::NONE;
+            }
+
+            std::string path = assetCache.getPath(asset, uvTransform);
+            if (path.empty()) {
+                throw std::runtime_error("failed to save scene, an asset wasn't loaded through the asset cache");
+            }
+
+            auto [it, inserted] = stringOffsets.try_emplace(path, static_cast<uint32_t>(strings.size()));
+            if (inserted) {
+                strings.append(path);
+                strings.push_back('\0');
+            }
+            return it->second;
+        };
+
+        std::vector<SceneObjectRecord> records(ids.size());
+        for (size_t i = 0; i < ids.size(); i++) {
+            BananGameObject::id_t id = ids[i];
+            SceneObjectRecord &record = records[i];
+            memset(&record, 0, sizeof(record));
+
+            auto parent = manager.getParent(id);
+            record.parent = parent == BananGameObject::NO_PARENT ? SceneObjectRecord::NONE : recordIndices[parent];
+            record.model = record.texture = record.normal = record.height = SceneObjectRecord::NONE;
+
+            auto &transform = manager.pool<TransformComponent>().get(id);
+            memcpy(record.translation, &transform.translation, sizeof(record.translation));
+            memcpy(record.rotation, &transform.rotation, sizeof(record.rotation));
+            memcpy(record.scale, &transform.scale, sizeof(record.scale));
+
+            glm::vec4 uvTransform{1.f, 1.f, 0.f, 0.f};
+            if (manager.pool<MaterialComponent>().has(id)) {
+                auto &material = manager.pool<MaterialComponent>().get(id);
+                record.flags |= SceneObjectRecord::HAS_MATERIAL;
+                record.texture = addString(material.texture.get(), material.uvTransform);
+                record.normal = addString(material.normal.get(), material.normalUvTransform);
+                record.height = addString(material.height.get(), material.heightUvTransform);
+                uvTransform = material.uvTransform;
+            }
+            memcpy(record.uvTransform, &uvTransform, sizeof(record.uvTransform));
+
+            if (manager.pool<ModelComponent>().has(id)) {
+                record.flags |= SceneObjectRecord::HAS_MODEL;
+                record.model = addString(manager.pool<ModelComponent>().get(id).model.get());
+            }
+
+            ParallaxComponent parallax{};
+            if (manager.pool<ParallaxComponent>().has(id)) {
+                record.flags |= SceneObjectRecord::HAS_PARALLAX;
+                parallax = manager.pool<ParallaxComponent>().get(id);
+            }
+            record.heightscale = parallax.heightscale;
+            record.parallaxBias = parallax.parallaxBias;
+            record.numLayers = parallax.numLayers;
+            record.parallaxmode = parallax.parallaxmode;
+
+            if (manager.pool<PointLightComponent>().has(id)) {
+                auto &light = manager.pool<PointLightComponent>().get(id);
+                record.flags |= SceneObjectRecord::IS_POINT_LIGHT;
+                record.lightIntensity = light.lightIntensity;
+                memcpy(record.lightColor, &light.color, sizeof(record.lightColor));
+            }
+        }
+
+        SceneFileHeader header{};
+        memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+        header.version = VERSION;
+        header.objectCount = static_cast<uint32_t>(records.size());
+        header.recordSize = sizeof(SceneObjectRecord);
+        header.stringsOffset = sizeof(SceneFileHeader);
+        header.stringsSize = strings.size();
+        header.recordsOffset = (header.stringsOffset + header.stringsSize + alignof(SceneObjectRecord) - 1) / alignof(SceneObjectRecord) * alignof(SceneObjectRecord);
+
+        size_t written = 0;
+        if (savePatch(header, strings, records, written)) {
+            return written;
+        }
+
+        saveFull(header, strings, records);
+        return records.size();
+    }
+
+    bool BananSceneFile::savePatch(const SceneFileHeader &header, const std::string &strings, const std::vector<SceneObjectRecord> &records, size_t &written) {
+        MappedFile file{filepath, true};
+        uint64_t fileSize = header.recordsOffset + records.size() * sizeof(SceneObjectRecord);
+        if (!file.isOpen() || file.getSize() != fileSize) {
+            return false;
+        }
+
+        // same layout means the header and string table are byte for byte identical, then only records can differ
+        if (memcmp(file.bytes(), &header, sizeof(header)) != 0 || memcmp(file.bytes() + header.stringsOffset, strings.data(), strings.size()) != 0) {
+            return false;
+        }
+
+        auto *fileRecords = reinterpret_cast<SceneObjectRecord *>(file.bytes() + header.recordsOffset);
+        written = 0;
+        for (size_t i = 0; i < records.size(); i++) {
+            if (memcmp(&fileRecords[i], &records[i], sizeof(SceneObjectRecord)) != 0) {
+                memcpy(&fileRecords[i], &records[i], sizeof(SceneObjectRecord));
+                written++;
+            }
+        }
+
+        if (written > 0) {
+            file.flush();
+        }
+        return true;
+    }
+
+    void BananSceneFile::saveFull(const SceneFileHeader &header, const std::string &strings, const std::vector<SceneObjectRecord> &records) {
+        // written next to the target and swapped in, so a failed save never leaves a half written scene behind
+        std::string temporaryPath = filepath + ".tmp";
+        {
+            std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to save scene: " + filepath);
+            }
+
+            std::vector<char> padding(header.recordsOffset - header.stringsOffset - header.stringsSize, 0);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+            file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            file.write(reinterpret_cast<const char *>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(SceneObjectRecord)));
+
+            if (!file) {
+                throw std::runtime_error("failed to save scene: " + filepath);
+            }
+        }
+
+        std::filesystem::rename(temporaryPath, filepath);
+    }
+}
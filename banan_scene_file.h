@@ -0,0 +1,74 @@
+#pragma once
+
+#include "banan_game_object.h"
+#include "banan_asset_cache.h"
+#include "banan_job_system.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Banan {
+    // header, then the string table holding every asset path, then one fixed size record per object. records can be
+    // found by index without parsing anything before them, which is also what lets saves patch them in place
+    struct SceneFileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t objectCount;
+        uint32_t recordSize;
+        uint64_t stringsOffset;
+        uint64_t stringsSize;
+        uint64_t recordsOffset;
+    };
+
+    struct SceneObjectRecord {
+        static constexpr uint32_t HAS_MODEL = 1 << 0;
+        static constexpr uint32_t HAS_MATERIAL = 1 << 1;
+        static constexpr uint32_t HAS_PARALLAX = 1 << 2;
+        static constexpr uint32_t IS_POINT_LIGHT = 1 << 3;
+        static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+        uint32_t flags;
+        uint32_t parent; // record index or NONE
+
+        float translation[3];
+        float rotation[3];
+        float scale[3];
+        float uvTransform[4];
+
+        float heightscale;
+        float parallaxBias;
+        float numLayers;
+        int32_t parallaxmode;
+
+        float lightIntensity;
+        float lightColor[3];
+
+        // offsets into the string table or NONE
+        uint32_t model;
+        uint32_t texture;
+        uint32_t normal;
+        uint32_t height;
+    };
+
+    class BananSceneFile {
+    public:
+        static constexpr uint32_t VERSION = 1;
+
+        explicit BananSceneFile(std::string filepath);
+
+        // maps the file, resolves every referenced asset in parallel through the cache and creates the objects, returns
+        // their ids in record order
+        std::vector<BananGameObject::id_t> load(BananGameObjectManager &manager, BananAssetCache &assetCache, BananJobSystem &jobSystem);
+
+        // records are matched to objects by id order, only the ones that differ from the file get written when the object
+        // count and the asset paths haven't changed, otherwise the file is rewritten. returns the number of records written
+        size_t save(BananGameObjectManager &manager, const BananAssetCache &assetCache);
+
+    private:
+        bool savePatch(const SceneFileHeader &header, const std::string &strings, const std::vector<SceneObjectRecord> &records, size_t &written);
+        void saveFull(const SceneFileHeader &header, const std::string &strings, const std::vector<SceneObjectRecord> &records);
+
+        std::string filepath;
+    };
+}
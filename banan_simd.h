@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#define BANAN_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BANAN_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define BANAN_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// thin wrappers so kernels can be written once and instantiated for the widest vector the target has, plus the scalar
+// versions for the tail. every backend provides the same set of free functions
+namespace Banan::Simd {
+
+    struct ScalarFloat {
+        static constexpr size_t WIDTH = 1;
+        float v;
+    };
+
+    struct ScalarInt {
+        int32_t v;
+    };
+
+    inline ScalarFloat broadcast(ScalarFloat, float value) { return {value}; }
+    inline ScalarFloat load(ScalarFloat, const float *data) { return {*data}; }
+    inline void store(float *data, ScalarFloat a) { *data = a.v; }
+    inline ScalarFloat operator+(ScalarFloat a, ScalarFloat b) { return {a.v + b.v}; }
+    inline ScalarFloat operator-(ScalarFloat a, ScalarFloat b) { return {a.v - b.v}; }
+    inline ScalarFloat operator*(ScalarFloat a, ScalarFloat b) { return {a.v * b.v}; }
+    inline ScalarFloat operator/(ScalarFloat a, ScalarFloat b) { return {a.v / b.v}; }
+    inline ScalarFloat fmadd(ScalarFloat a, ScalarFloat b, ScalarFloat c) { return {a.v * b.v + c.v}; }
+    inline ScalarInt roundToInt(ScalarFloat a) { return {static_cast<int32_t>(a.v >= 0.f ? a.v + 0.5f : a.v - 0.5f)}; }
+    inline ScalarFloat toFloat(ScalarInt a) { return {static_cast<float>(a.v)}; }
+    inline ScalarInt operator&(ScalarInt a, int32_t b) { return {a.v & b}; }
+    inline ScalarInt operator+(ScalarInt a, int32_t b) { return {a.v + b}; }
+    template<int Shift> inline ScalarInt shiftLeft(ScalarInt a) { return {static_cast<int32_t>(static_cast<uint32_t>(a.v) << Shift)}; }
+    inline ScalarInt equalsZero(ScalarInt a) { return {a.v == 0 ? -1 : 0}; }
+    inline ScalarFloat flipSign(ScalarFloat a, ScalarInt signBits) {
+        uint32_t bits;
+        memcpy(&bits, &a.v, sizeof(bits));
+        bits ^= static_cast<uint32_t>(signBits.v);
+        memcpy(&a.v, &bits, sizeof(bits));
+        return a;
+    }
+    inline ScalarFloat select(ScalarInt mask, ScalarFloat a, ScalarFloat b) { return mask.v ? a : b; }
+    inline ScalarFloat abs(ScalarFloat a) { return {std::fabs(a.v)}; }
+    inline ScalarInt lessThan(ScalarFloat a, ScalarFloat b) { return {a.v < b.v ? -1 : 0}; }
+    inline ScalarInt operator|(ScalarInt a, ScalarInt b) { return {a.v | b.v}; }
+    // one bit per lane, set where the mask lane is
+    inline uint32_t moveMask(ScalarInt a) { return a.v ? 1u : 0u; }
+
+#if defined(BANAN_SIMD_AVX2)
+    struct NativeFloat {
+        static constexpr size_t WIDTH = 8;
+        __m256 v;
+    };
+
+    struct NativeInt {
+        __m256i v;
+    };
+
+    inline NativeFloat broadcast(NativeFloat, float value) { return {_mm256_set1_ps(value)}; }
+    inline NativeFloat load(NativeFloat, const float *data) { return {_mm256_loadu_ps(data)}; }
+    inline void store(float *data, NativeFloat a) { _mm256_storeu_ps(data, a.v); }
+    inline NativeFloat operator+(NativeFloat a, NativeFloat b) { return {_mm256_add_ps(a.v, b.v)}; }
+    inline NativeFloat operator-(NativeFloat a, NativeFloat b) { return {_mm256_sub_ps(a.v, b.v)}; }
+    inline NativeFloat operator*(NativeFloat a, NativeFloat b) { return {_mm256_mul_ps(a.v, b.v)}; }
+    inline NativeFloat operator/(NativeFloat a, NativeFloat b) { return {_mm256_div_ps(a.v, b.v)}; }
+#if defined(__FMA__)
+    inline NativeFloat fmadd(NativeFloat a, NativeFloat b, NativeFloat c) { return {_mm256_fmadd_ps(a.v, b.v, c.v)}; }
+#else
+    inline NativeFloat fmadd(NativeFloat a, NativeFloat b, NativeFloat c) { return {_mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v)}; }
+#endif
+    inline NativeInt roundToInt(NativeFloat a) { return {_mm256_cvtps_epi32(a.v)}; }
+    inline NativeFloat toFloat(NativeInt a) { return {_mm256_cvtepi32_ps(a.v)}; }
+    inline NativeInt operator&(NativeInt a, int32_t b) { return {_mm256_and_si256(a.v, _mm256_set1_epi32(b))}; }
+    inline NativeInt operator+(NativeInt a, int32_t b) { return {_mm256_add_epi32(a.v, _mm256_set1_epi32(b))}; }
+    template<int Shift> inline NativeInt shiftLeft(NativeInt a) { return {_mm256_slli_epi32(a.v, Shift)}; }
+    inline NativeInt equalsZero(NativeInt a) { return {_mm256_cmpeq_epi32(a.v, _mm256_setzero_si256())}; }
+    inline NativeFloat flipSign(NativeFloat a, NativeInt signBits) { return {_mm256_xor_ps(a.v, _mm256_castsi256_ps(signBits.v))}; }
+    inline NativeFloat select(NativeInt mask, NativeFloat a, NativeFloat b) { return {_mm256_blendv_ps(b.v, a.v, _mm256_castsi256_ps(mask.v))}; }
+    inline NativeFloat abs(NativeFloat a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v)}; }
+    inline NativeInt lessThan(NativeFloat a, NativeFloat b) { return {_mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ))}; }
+    inline NativeInt operator|(NativeInt a, NativeInt b) { return {_mm256_or_si256(a.v, b.v)}; }
+    inline uint32_t moveMask(NativeInt a) { return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(a.v))); }
+#elif defined(BANAN_SIMD_SSE2)
+    struct NativeFloat {
+        static constexpr size_t WIDTH = 4;
+        __m128 v;
+    };
+
+    struct NativeInt {
+        __m128i v;
+    };
+
+    inline NativeFloat broadcast(NativeFloat, float value) { return {_mm_set1_ps(value)}; }
+    inline NativeFloat load(NativeFloat, const float *data) { return {_mm_loadu_ps(data)}; }
+    inline void store(float *data, NativeFloat a) { _mm_storeu_ps(data, a.v); }
+    inline NativeFloat operator+(NativeFloat a, NativeFloat b) { return {_mm_add_ps(a.v, b.v)}; }
+    inline NativeFloat operator-(NativeFloat a, NativeFloat b) { return {_mm_sub_ps(a.v, b.v)}; }
+    inline NativeFloat operator*(NativeFloat a, NativeFloat b) { return {_mm_mul_ps(a.v, b.v)}; }
+    inline NativeFloat operator/(NativeFloat a, NativeFloat b) { return {_mm_div_ps(a.v, b.v)}; }
+    inline NativeFloat fmadd(NativeFloat a, NativeFloat b, NativeFloat c) { return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)}; }
+    inline NativeInt roundToInt(NativeFloat a) { return {_mm_cvtps_epi32(a.v)}; }
+    inline NativeFloat toFloat(NativeInt a) { return {_mm_cvtepi32_ps(a.v)}; }
+    inline NativeInt operator&(NativeInt a, int32_t b) { return {_mm_and_si128(a.v, _mm_set1_epi32(b))}; }
+    inline NativeInt operator+(NativeInt a, int32_t b) { return {_mm_add_epi32(a.v, _mm_set1_epi32(b))}; }
+    template<int Shift> inline NativeInt shiftLeft(NativeInt a) { return {_mm_slli_epi32(a.v, Shift)}; }
+    inline NativeInt equalsZero(NativeInt a) { return {_mm_cmpeq_epi32(a.v, _mm_setzero_si128())}; }
+    inline NativeFloat flipSign(NativeFloat a, NativeInt signBits) { return {_mm_xor_ps(a.v, _mm_castsi128_ps(signBits.v))}; }
+    inline NativeFloat select(NativeInt mask, NativeFloat a, NativeFloat b) {
+        __m128 m = _mm_castsi128_ps(mask.v);
+        return {_mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v))};
+    }
+    inline NativeFloat abs(NativeFloat a) { return {_mm_andnot_ps(_mm_set1_ps(-0.f), a.v)}; }
+    inline NativeInt lessThan(NativeFloat a, NativeFloat b) { return {_mm_castps_si128(_mm_cmplt_ps(a.v, b.v))}; }
+    inline NativeInt operator|(NativeInt a, NativeInt b) { return {_mm_or_si128(a.v, b.v)}; }
+    inline uint32_t moveMask(NativeInt a) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(a.v))); }
+#elif defined(BANAN_SIMD_NEON)
+    struct NativeFloat {
+        static constexpr size_t WIDTH = 4;
+        float32x4_t v;
+    };
+
+    struct NativeInt {
+        int32x4_t v;
+    };
+
+    inline NativeFloat broadcast(NativeFloat, float value) { return {vdupq_n_f32(value)}; }
+    inline NativeFloat load(NativeFloat, const float *data) { return {vld1q_f32(data)}; }
+    inline void store(float *data, NativeFloat a) { vst1q_f32(data, a.v); }
+    inline NativeFloat operator+(NativeFloat a, NativeFloat b) { return {vaddq_f32(a.v, b.v)}; }
+    inline NativeFloat operator-(NativeFloat a, NativeFloat b) { return {vsubq_f32(a.v, b.v)}; }
+    inline NativeFloat operator*(NativeFloat a, NativeFloat b) { return {vmulq_f32(a.v, b.v)}; }
+    inline NativeFloat operator/(NativeFloat a, NativeFloat b) { return {vdivq_f32(a.v, b.v)}; }
+    inline NativeFloat fmadd(NativeFloat a, NativeFloat b, NativeFloat c) { return {vfmaq_f32(c.v, a.v, b.v)}; }
+    inline NativeInt roundToInt(NativeFloat a) { return {vcvtnq_s32_f32(a.v)}; }
+    inline NativeFloat toFloat(NativeInt a) { return {vcvtq_f32_s32(a.v)}; }
+    inline NativeInt operator&(NativeInt a, int32_t b) { return {vandq_s32(a.v, vdupq_n_s32(b))}; }
+    inline NativeInt operator+(NativeInt a, int32_t b) { return {vaddq_s32(a.v, vdupq_n_s32(b))}; }
+    template<int Shift> inline NativeInt shiftLeft(NativeInt a) { return {vshlq_n_s32(a.v, Shift)}; }
+    inline NativeInt equalsZero(NativeInt a) { return {vreinterpretq_s32_u32(vceqq_s32(a.v, vdupq_n_s32(0)))}; }
+    inline NativeFloat flipSign(NativeFloat a, NativeInt signBits) { return {vreinterpretq_f32_s32(veorq_s32(vreinterpretq_s32_f32(a.v), signBits.v))}; }
+    inline NativeFloat select(NativeInt mask, NativeFloat a, NativeFloat b) { return {vbslq_f32(vreinterpretq_u32_s32(mask.v), a.v, b.v)}; }
+    inline NativeFloat abs(NativeFloat a) { return {vabsq_f32(a.v)}; }
+    inline NativeInt lessThan(NativeFloat a, NativeFloat b) { return {vreinterpretq_s32_u32(vcltq_f32(a.v, b.v))}; }
+    inline NativeInt operator|(NativeInt a, NativeInt b) { return {vorrq_s32(a.v, b.v)}; }
+    inline uint32_t moveMask(NativeInt a) {
+        // each lane's sign bit shifted down to bit 0 and then up to its lane index
+        const int32_t shifts[4] = {0, 1, 2, 3};
+        uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_s32(a.v), 31);
+        return vaddvq_u32(vshlq_u32(bits, vld1q_s32(shifts)));
+    }
+#else
+    using NativeFloat = ScalarFloat;
+    using NativeInt = ScalarInt;
+#endif
+
+    // cephes style sincos, reduced to [-pi/4, pi/4] around the nearest multiple of pi/2, accurate to a couple of ulp
+    // for the angle ranges transforms use
+    template<typename F>
+    inline void sincos(F x, F &sin, F &cos) {
+        auto quadrant = roundToInt(x * broadcast(F{}, 0.636619772367581343f));
+        F q = toFloat(quadrant);
+
+        // pi/2 split in three so the reduction stays exact for large quadrants
+        F r = fmadd(q, broadcast(F{}, -1.5703125f), x);
+        r = fmadd(q, broadcast(F{}, -4.837512969970703125e-4f), r);
+        r = fmadd(q, broadcast(F{}, -7.54978995489188216e-8f), r);
+
+        F r2 = r * r;
+
+        F sinPoly = fmadd(r2, broadcast(F{}, -1.9515295891e-4f), broadcast(F{}, 8.3321608736e-3f));
+        sinPoly = fmadd(sinPoly, r2, broadcast(F{}, -1.6666654611e-1f));
+        sinPoly = fmadd(sinPoly * r2, r, r);
+
+        F cosPoly = fmadd(r2, broadcast(F{}, 2.443315711809948e-5f), broadcast(F{}, -1.388731625493765e-3f));
+        cosPoly = fmadd(cosPoly, r2, broadcast(F{}, 4.166664568298827e-2f));
+        cosPoly = fmadd(cosPoly, r2 * r2, fmadd(r2, broadcast(F{}, -0.5f), broadcast(F{}, 1.0f)));
+
+        // odd quadrants swap sin and cos, the sign follows bit 1 of the quadrant (and of quadrant + 1 for cos)
+        auto noSwap = equalsZero(quadrant & 1);
+        sin = flipSign(select(noSwap, sinPoly, cosPoly), shiftLeft<30>(quadrant & 2));
+        cos = flipSign(select(noSwap, cosPoly, sinPoly), shiftLeft<30>((quadrant + 1) & 2));
+    }
+}
@@ -37,6 +37,7 @@ namespace Banan {
 
         vkDestroyFramebuffer(device.device(), geometryFramebuffer, nullptr);
         vkDestroyRenderPass(device.device(), geometryRenderpass, nullptr);
+        vkDestroyRenderPass(device.device(), earlyGeometryRenderpass, nullptr);
 
         vkDestroyFramebuffer(device.device(), edgeDetectionFramebuffer, nullptr);
         vkDestroyRenderPass(device.device(), edgeDetectionRenderPass, nullptr);
@@ -87,7 +88,7 @@ namespace Banan {
         submitInfo.pSignalSemaphores = signalSemaphores;
 
         vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+        if (device.queueSubmit(1, &submitInfo, inFlightFences[currentFrame]) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to submit draw command buffer!");
         }
@@ -104,7 +105,7 @@ namespace Banan {
 
         presentInfo.pImageIndices = imageIndex;
 
-        auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+        auto result = device.queuePresent(presentInfo);
 
         currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -353,6 +354,26 @@ namespace Banan {
         renderPassInfo.dependencyCount = dependencies.size();
         renderPassInfo.pDependencies = dependencies.data();
 
+        // the early pass starts the g-buffer from scratch, nothing reads its composite target
+        std::vector<VkAttachmentDescription> earlyAttachments = attachments;
+        earlyAttachments[3].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        earlyAttachments[3].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        renderPassInfo.pAttachments = earlyAttachments.data();
+
+        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &earlyGeometryRenderpass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render pass!");
+        }
+
+        // the main pass picks the g-buffer up in the layouts the early pass left it in
+        attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[0].initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[1].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachments[2].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments[2].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        renderPassInfo.pAttachments = attachments.data();
+
         if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &geometryRenderpass) != VK_SUCCESS) {
             throw std::runtime_error("failed to create render pass!");
         }
@@ -632,9 +653,11 @@ namespace Banan {
 
     void BananSwapChain::createGBufferResources() {
         swapChainDepthFormat =  findDepthFormat();
-        gBufferAttachments.push_back(std::make_shared<BananImage>(device, swapChainExtent.width, swapChainExtent.height, 1, swapChainDepthFormat, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+        gBufferAttachments.push_back(std::make_shared<BananImage>(device, swapChainExtent.width, swapChainExtent.height, 1, swapChainDepthFormat, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
         gBufferAttachments.push_back(std::make_shared<BananImage>(device, swapChainExtent.width, swapChainExtent.height, 1, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
         gBufferAttachments.push_back(std::make_shared<BananImage>(device, swapChainExtent.width, swapChainExtent.height, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+
+        depthPyramidImage = std::make_shared<BananDepthPyramid>(device, swapChainExtent);
     }
 
     void BananSwapChain::createResolveResources() {
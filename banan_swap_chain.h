@@ -6,6 +6,7 @@
 
 #include "banan_device.h"
 #include "banan_image.h"
+#include "banan_depth_pyramid.h"
 
 // vulkan headers
 #include <vulkan/vulkan.h>
@@ -28,6 +29,9 @@ namespace Banan {
 
         VkFramebuffer getGeometryFramebuffer() { return geometryFramebuffer; }
         VkRenderPass getGeometryRenderpass() { return geometryRenderpass; }
+        // clears and fills the g-buffer ahead of the occlusion test, the geometry pass then loads it. the two are compatible
+        // so the geometry framebuffer and g-buffer pipelines work with both
+        VkRenderPass getEarlyGeometryRenderpass() { return earlyGeometryRenderpass; }
 
         VkFramebuffer getEdgeDetectionFramebuffer() { return edgeDetectionFramebuffer; }
         VkRenderPass getEdgeDetectionRenderPass() { return edgeDetectionRenderPass; }
@@ -49,6 +53,7 @@ namespace Banan {
         std::shared_ptr<BananImage> geometry() { return geometryImage; }
         std::shared_ptr<BananImage> edge() { return edgeImage; }
         std::shared_ptr<BananImage> blend() { return blendImage; }
+        std::shared_ptr<BananDepthPyramid> depthPyramid() { return depthPyramidImage; }
 
         float extentAspectRatio() {
             return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
@@ -83,6 +88,7 @@ namespace Banan {
 
         VkFramebuffer geometryFramebuffer;
         VkRenderPass geometryRenderpass;
+        VkRenderPass earlyGeometryRenderpass;
 
         VkFramebuffer edgeDetectionFramebuffer;
         VkFramebuffer blendFramebuffer;
@@ -93,6 +99,7 @@ namespace Banan {
         VkRenderPass resolveRenderPass;
 
         std::vector<std::shared_ptr<BananImage>> gBufferAttachments;
+        std::shared_ptr<BananDepthPyramid> depthPyramidImage;
 
         std::shared_ptr<BananImage> geometryImage;
         std::shared_ptr<BananImage> edgeImage;
@@ -0,0 +1,170 @@
+#include "banan_texture_atlas.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+namespace Banan {
+
+    BananTextureAtlas::BananTextureAtlas(BananDevice &device, uint32_t pageSize, uint32_t padding, uint32_t maxEntrySize) : bananDevice{device}, pageSize{pageSize}, padding{padding}, maxEntrySize{maxEntrySize} {
+        assert(maxEntrySize + 2 * padding <= pageSize && "Atlas entries must fit inside a page");
+    }
+
+    BananTextureAtlas::~BananTextureAtlas() {
+        // entries added but never built still own their pixels
+        for (auto &entry : pending) {
+            entry.texture.release();
+        }
+    }
+
+    bool BananTextureAtlas::canPack(const BananModel::Texture &texture) const {
+        return texture.width > 0 && texture.height > 0 && texture.width <= maxEntrySize && texture.height <= maxEntrySize && (texture.stride == 8 || texture.stride == 16);
+    }
+
+    uint32_t BananTextureAtlas::add(BananModel::Texture texture) {
+        assert(canPack(texture) && "Texture is too large or has an unsupported format for the atlas");
+
+        auto index = static_cast<uint32_t>(regions.size());
+        regions.emplace_back();
+        pending.push_back({texture});
+        pendingIndices.push_back(index);
+        return index;
+    }
+
+    uint32_t BananTextureAtlas::add(const std::string &filepath, BananModel::TextureType type) {
+        BananModel::Builder builder{};
+        builder.loadImage(filepath, builder.texture, type);
+
+        if (canPack(builder.texture)) {
+            return add(builder.texture);
+        }
+
+        // too big to be worth packing, it keeps its own image with an identity transform
+        auto index = static_cast<uint32_t>(regions.size());
+        regions.push_back({BananModel::createImageFromTexture(bananDevice, builder.texture)});
+        builder.texture.release();
+        return index;
+    }
+
+    void BananTextureAtlas::build() {
+        uint32_t alignment = std::max(padding, 1u);
+        auto alignUp = [alignment](uint32_t value) { return (value + alignment - 1) / alignment * alignment; };
+
+        // mips past log2(padding) would blend neighbouring entries together, the page stops there so sampling can't go further
+        uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(alignment))) + 1;
+
+        // only entries with the same pixel format can share a page
+        std::map<VkFormat, std::vector<size_t>> groups;
+        for (size_t i = 0; i < pending.size(); i++) {
+            groups[pending[i].texture.getFormat()].push_back(i);
+        }
+
+        for (auto &[format, group] : groups) {
+            std::sort(group.begin(), group.end(), [this](size_t a, size_t b) { return pending[a].texture.height > pending[b].texture.height; });
+
+            // shelf packing, entries are sorted by height so each shelf wastes little vertical space
+            uint32_t pageCount = 1;
+            uint32_t cursorX = 0;
+            uint32_t shelfY = 0;
+            uint32_t shelfHeight = 0;
+
+            for (size_t i : group) {
+                Entry &entry = pending[i];
+                uint32_t cellWidth = alignUp(entry.texture.width + 2 * padding);
+                uint32_t cellHeight = alignUp(entry.texture.height + 2 * padding);
+
+                if (cursorX + cellWidth > pageSize) {
+                    cursorX = 0;
+                    shelfY += shelfHeight;
+                    shelfHeight = 0;
+                }
+
+                if (shelfY + cellHeight > pageSize) {
+                    pageCount++;
+                    cursorX = 0;
+                    shelfY = 0;
+                    shelfHeight = 0;
+                }
+
+                entry.page = pageCount - 1;
+                entry.x = cursorX + padding;
+                entry.y = shelfY + padding;
+
+                cursorX += cellWidth;
+                shelfHeight = std::max(shelfHeight, cellHeight);
+            }
+
+            const BananModel::Texture &groupFormat = pending[group.front()].texture;
+            size_t pixelSize = groupFormat.getPixelSize();
+            size_t pageBytes = static_cast<size_t>(pageSize) * pageSize * pixelSize;
+
+            for (uint32_t page = 0; page < pageCount; page++) {
+                auto *pageData = static_cast<uint8_t *>(calloc(pageBytes, 1));
+                if (pageData == nullptr) {
+                    throw std::runtime_error("failed to allocate atlas page");
+                }
+
+                for (size_t i : group) {
+                    if (pending[i].page == page) {
+                        blit(pending[i], pageData, pixelSize);
+                    }
+                }
+
+                BananModel::Texture pageTexture{pageData, groupFormat.stride, pageSize, pageSize, mipLevels, groupFormat.channels, groupFormat.floatingPoint, groupFormat.type};
+                std::shared_ptr<BananImage> pageImage = BananModel::createImageFromTexture(bananDevice, pageTexture);
+                free(pageData);
+                pages.push_back(pageImage);
+
+                float invSize = 1.0f / static_cast<float>(pageSize);
+                for (size_t i : group) {
+                    const Entry &entry = pending[i];
+                    if (entry.page != page) {
+                        continue;
+                    }
+
+                    BananAtlasRegion &region = regions[pendingIndices[i]];
+                    region.page = pageImage;
+                    region.uvTransform = {entry.texture.width * invSize, entry.texture.height * invSize, entry.x * invSize, entry.y * invSize};
+                }
+            }
+        }
+
+        for (auto &entry : pending) {
+            entry.texture.release();
+        }
+
+        pending.clear();
+        pendingIndices.clear();
+    }
+
+    const BananAtlasRegion &BananTextureAtlas::getRegion(uint32_t entry) const {
+        assert(regions[entry].page != nullptr && "Atlas region requested before build");
+        return regions[entry];
+    }
+
+    void BananTextureAtlas::blit(const Entry &entry, uint8_t *pageData, size_t pixelSize) const {
+        const auto *source = static_cast<const uint8_t *>(entry.texture.data);
+        auto width = static_cast<int64_t>(entry.texture.width);
+        auto height = static_cast<int64_t>(entry.texture.height);
+        auto pad = static_cast<int64_t>(padding);
+        size_t rowBytes = width * pixelSize;
+
+        // the gutter continues the texture from its opposite edge, the shader wraps uvs into the entry, so bilinear filtering
+        // and the first few mips across the seam see what a repeating sampler would and never pull in a neighbour
+        auto wrap = [](int64_t value, int64_t size) { return ((value % size) + size) % size; };
+        for (int64_t y = -pad; y < height + pad; y++) {
+            const uint8_t *sourceRow = source + wrap(y, height) * rowBytes;
+            uint8_t *destRow = pageData + ((entry.y + y) * pageSize + entry.x) * pixelSize;
+
+            memcpy(destRow, sourceRow, rowBytes);
+            for (int64_t x = 1; x <= pad; x++) {
+                memcpy(destRow - x * pixelSize, sourceRow + wrap(-x, width) * pixelSize, pixelSize);
+                memcpy(destRow + (width - 1 + x) * pixelSize, sourceRow + wrap(width - 1 + x, width) * pixelSize, pixelSize);
+            }
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "banan_model.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Banan {
+    struct BananAtlasRegion {
+        std::shared_ptr<BananImage> page;
+        glm::vec4 uvTransform{1.f, 1.f, 0.f, 0.f}; // xy scale, zw offset, matches GameObjectData::uvTransform
+    };
+
+    class BananTextureAtlas {
+    public:
+        BananTextureAtlas(BananDevice &device, uint32_t pageSize = 2048, uint32_t padding = 4, uint32_t maxEntrySize = 256);
+        ~BananTextureAtlas();
+
+        BananTextureAtlas(const BananTextureAtlas &) = delete;
+        BananTextureAtlas &operator=(const BananTextureAtlas &) = delete;
+
+        bool canPack(const BananModel::Texture &texture) const;
+
+        // takes ownership of the texture's pixel data, returns the entry index used to look up its region after build
+        uint32_t add(BananModel::Texture texture);
+        uint32_t add(const std::string &filepath, BananModel::TextureType type = BananModel::TextureType::ALBEDO);
+
+        // packs every added texture into pages and uploads them, entries added afterwards go into new pages
+        void build();
+
+        const BananAtlasRegion &getRegion(uint32_t entry) const;
+        size_t getPageCount() const { return pages.size(); }
+
+    private:
+        struct Entry {
+            BananModel::Texture texture;
+            uint32_t x = 0;
+            uint32_t y = 0;
+            uint32_t page = 0;
+        };
+
+        void blit(const Entry &entry, uint8_t *pageData, size_t pixelSize) const;
+
+        BananDevice &bananDevice;
+        uint32_t pageSize;
+        uint32_t padding;
+        uint32_t maxEntrySize;
+
+        std::vector<Entry> pending;
+        std::vector<uint32_t> pendingIndices;
+        std::vector<BananAtlasRegion> regions;
+        std::vector<std::shared_ptr<BananImage>> pages;
+    };
+}
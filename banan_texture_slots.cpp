@@ -0,0 +1,108 @@
+#include "banan_texture_slots.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+namespace Banan {
+
+    BananTextureSlots::BananTextureSlots(BananDevice &device, uint32_t capacity) : bananDevice{device}, capacity{capacity} {
+    }
+
+    uint32_t BananTextureSlots::acquire(const std::shared_ptr<BananImage> &image) {
+        assert(image != nullptr && "Cannot acquire a slot for a null image");
+
+        if (auto it = lookup.find(image.get()); it != lookup.end()) {
+            slots[it->second].references++;
+            return it->second;
+        }
+
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            std::pop_heap(freeSlots.begin(), freeSlots.end(), std::greater<>{});
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            assert(slots.size() < capacity && "Max texture slot count exceeded");
+            slot = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        Slot &entry = slots[slot];
+        entry.image = image;
+        entry.references = 1;
+        lookup.emplace(image.get(), slot);
+
+        for (uint8_t frame = 0; frame < BananSwapChain::MAX_FRAMES_IN_FLIGHT; frame++) {
+            if ((entry.dirtyMask & (1 << frame)) == 0) {
+                entry.dirtyMask |= 1 << frame;
+                dirtySlots[frame].push_back(slot);
+            }
+        }
+
+        return slot;
+    }
+
+    void BananTextureSlots::release(uint32_t slot) {
+        Slot &entry = slots[slot];
+        assert(entry.references > 0 && "Texture slot released more often than acquired");
+
+        if (--entry.references > 0) {
+            return;
+        }
+
+        // the image stays alive and in the descriptor array until the frames that might still sample it are done
+        lookup.erase(entry.image.get());
+        retiredSlots.push_back({slot, currentFrame});
+    }
+
+    void BananTextureSlots::advanceFrame() {
+        currentFrame++;
+
+        auto expired = std::partition(retiredSlots.begin(), retiredSlots.end(), [this](const RetiredSlot &retired) {
+            return retired.releasedFrame + BananSwapChain::MAX_FRAMES_IN_FLIGHT > currentFrame;
+        });
+
+        for (auto it = expired; it != retiredSlots.end(); ++it) {
+            slots[it->slot].image.reset();
+            freeSlots.push_back(it->slot);
+            std::push_heap(freeSlots.begin(), freeSlots.end(), std::greater<>{});
+        }
+        retiredSlots.erase(expired, retiredSlots.end());
+    }
+
+    void BananTextureSlots::writeDescriptors(int frameIndex, VkDescriptorSet set, uint32_t binding) {
+        auto &pending = dirtySlots[frameIndex];
+        if (pending.empty()) {
+            return;
+        }
+
+        std::vector<VkDescriptorImageInfo> imageInfos;
+        imageInfos.reserve(pending.size());
+        std::vector<VkWriteDescriptorSet> writes;
+        writes.reserve(pending.size());
+
+        for (uint32_t slot : pending) {
+            Slot &entry = slots[slot];
+            entry.dirtyMask &= ~(1 << frameIndex);
+
+            // freed before this frame got to it, nothing points at it so the old descriptor can stay
+            if (entry.image == nullptr) continue;
+
+            imageInfos.push_back(entry.image->descriptorInfo());
+
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = set;
+            write.dstBinding = binding;
+            write.dstArrayElement = slot;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.descriptorCount = 1;
+            write.pImageInfo = &imageInfos.back();
+            writes.push_back(write);
+        }
+
+        vkUpdateDescriptorSets(bananDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        pending.clear();
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "banan_image.h"
+#include "banan_swap_chain.h"
+
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Banan {
+    // hands out indices into one bindless sampler array. every image gets a single refcounted slot no matter how many objects
+    // use it, and released slots are only reused once no frame in flight can still be sampling them
+    class BananTextureSlots {
+    public:
+        static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+        BananTextureSlots(BananDevice &device, uint32_t capacity);
+
+        BananTextureSlots(const BananTextureSlots &) = delete;
+        BananTextureSlots &operator=(const BananTextureSlots &) = delete;
+
+        uint32_t acquire(const std::shared_ptr<BananImage> &image);
+        void release(uint32_t slot);
+        const BananImage *getImage(uint32_t slot) const { return slots[slot].image.get(); }
+
+        // frees the slots released MAX_FRAMES_IN_FLIGHT frames ago, call once per frame
+        void advanceFrame();
+
+        // writes every slot acquired since this frame's set was last written, the set needs update after bind
+        void writeDescriptors(int frameIndex, VkDescriptorSet set, uint32_t binding = 0);
+
+        uint32_t getCapacity() const { return capacity; }
+        // highest slot ever handed out plus one, lowest free slots are reused first so this stays close to the live count
+        uint32_t size() const { return static_cast<uint32_t>(slots.size()); }
+
+    private:
+        struct Slot {
+            std::shared_ptr<BananImage> image;
+            uint32_t references = 0;
+            uint8_t dirtyMask = 0;
+        };
+
+        struct RetiredSlot {
+            uint32_t slot;
+            uint64_t releasedFrame;
+        };
+
+        BananDevice &bananDevice;
+        uint32_t capacity;
+        uint64_t currentFrame = 0;
+
+        std::vector<Slot> slots;
+        std::unordered_map<const BananImage *, uint32_t> lookup;
+        std::vector<uint32_t> freeSlots; // min heap
+        std::vector<RetiredSlot> retiredSlots;
+        std::vector<std::vector<uint32_t>> dirtySlots{BananSwapChain::MAX_FRAMES_IN_FLIGHT};
+    };
+}
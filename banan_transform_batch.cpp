@@ -0,0 +1,98 @@
+#include "banan_transform_batch.h"
+#include "banan_game_object.h"
+#include "banan_simd.h"
+
+namespace Banan {
+
+    void BananTransformBatch::clear() {
+        for (auto *field : {&translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ, &scaleX, &scaleY, &scaleZ}) {
+            field->clear();
+        }
+    }
+
+    void BananTransformBatch::reserve(size_t count) {
+        for (auto *field : {&translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ, &scaleX, &scaleY, &scaleZ}) {
+            field->reserve(count);
+        }
+    }
+
+    void BananTransformBatch::push(const TransformComponent &transform) {
+        translationX.push_back(transform.translation.x);
+        translationY.push_back(transform.translation.y);
+        translationZ.push_back(transform.translation.z);
+        rotationX.push_back(transform.rotation.x);
+        rotationY.push_back(transform.rotation.y);
+        rotationZ.push_back(transform.rotation.z);
+        scaleX.push_back(transform.scale.x);
+        scaleY.push_back(transform.scale.y);
+        scaleZ.push_back(transform.scale.z);
+    }
+
+    void BananTransformBatch::compute(glm::mat4 *modelMatrices, glm::mat3 *normalMatrices) const {
+        size_t count = size();
+        size_t i = 0;
+        for (; i + Simd::NativeFloat::WIDTH <= count; i += Simd::NativeFloat::WIDTH) {
+            computeLanes<Simd::NativeFloat>(i, modelMatrices, normalMatrices);
+        }
+
+        for (; i < count; i++) {
+            computeLanes<Simd::ScalarFloat>(i, modelMatrices, normalMatrices);
+        }
+    }
+
+    // same yxz tait-bryan matrices as TransformComponent::mat4 and normalMatrix, just for a vector of transforms at a time
+    template<typename F>
+    void BananTransformBatch::computeLanes(size_t first, glm::mat4 *modelMatrices, glm::mat3 *normalMatrices) const {
+        constexpr size_t WIDTH = F::WIDTH;
+
+        F s1, c1, s2, c2, s3, c3;
+        Simd::sincos(Simd::load(F{}, &rotationY[first]), s1, c1);
+        Simd::sincos(Simd::load(F{}, &rotationX[first]), s2, c2);
+        Simd::sincos(Simd::load(F{}, &rotationZ[first]), s3, c3);
+
+        // rotation basis, columns 0 to 2
+        F r00 = c1 * c3 + s1 * s2 * s3;
+        F r01 = c2 * s3;
+        F r02 = c1 * s2 * s3 - c3 * s1;
+        F r10 = c3 * s1 * s2 - c1 * s3;
+        F r11 = c2 * c3;
+        F r12 = c1 * c3 * s2 + s1 * s3;
+        F r20 = c2 * s1;
+        F r21 = Simd::broadcast(F{}, 0.f) - s2;
+        F r22 = c1 * c2;
+
+        F sx = Simd::load(F{}, &scaleX[first]);
+        F sy = Simd::load(F{}, &scaleY[first]);
+        F sz = Simd::load(F{}, &scaleZ[first]);
+
+        F one = Simd::broadcast(F{}, 1.f);
+        F ix = one / sx;
+        F iy = one / sy;
+        F iz = one / sz;
+
+        // lanes go back out through a small stack transpose, every output matrix is still written exactly once
+        float model[9][WIDTH];
+        float normal[9][WIDTH];
+        const F basis[9] = {r00, r01, r02, r10, r11, r12, r20, r21, r22};
+        const F scales[3] = {sx, sy, sz};
+        const F inverseScales[3] = {ix, iy, iz};
+        for (int column = 0; column < 3; column++) {
+            for (int row = 0; row < 3; row++) {
+                Simd::store(model[column * 3 + row], scales[column] * basis[column * 3 + row]);
+                Simd::store(normal[column * 3 + row], inverseScales[column] * basis[column * 3 + row]);
+            }
+        }
+
+        for (size_t lane = 0; lane < WIDTH; lane++) {
+            size_t index = first + lane;
+            glm::mat4 &modelMatrix = modelMatrices[index];
+            glm::mat3 &normalMatrix = normalMatrices[index];
+
+            for (int column = 0; column < 3; column++) {
+                modelMatrix[column] = {model[column * 3][lane], model[column * 3 + 1][lane], model[column * 3 + 2][lane], 0.f};
+                normalMatrix[column] = {normal[column * 3][lane], normal[column * 3 + 1][lane], normal[column * 3 + 2][lane]};
+            }
+            modelMatrix[3] = {translationX[index], translationY[index], translationZ[index], 1.f};
+        }
+    }
+}
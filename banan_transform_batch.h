@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Banan {
+    struct TransformComponent;
+
+    // structure of arrays copy of a set of transforms, so the matrix kernel can load a full vector of each field at once
+    class BananTransformBatch {
+    public:
+        void clear();
+        void reserve(size_t count);
+        void push(const TransformComponent &transform);
+        size_t size() const { return translationX.size(); }
+
+        // writes size() model and normal matrices, the six sines and cosines are computed once per transform and shared by both
+        void compute(glm::mat4 *modelMatrices, glm::mat3 *normalMatrices) const;
+
+    private:
+        template<typename F>
+        void computeLanes(size_t first, glm::mat4 *modelMatrices, glm::mat3 *normalMatrices) const;
+
+        std::vector<float> translationX, translationY, translationZ;
+        std::vector<float> rotationX, rotationY, rotationZ;
+        std::vector<float> scaleX, scaleY, scaleZ;
+    };
+}